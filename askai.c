@@ -1,16 +1,32 @@
 #include <curl/curl.h>
 #include <errno.h>  // Required for checking errno against EINTR
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>  // For fstat()
+#include <unistd.h>    // For STDIN_FILENO
 
 #include "apiKeyManager.h"
+#include "byteRing.h"
+#include "batch.h"
 #include "cJSON.h"
+#include "connectionCache.h"
+#include "daemon.h"
+#include "history.h"
 #include "jsonHandling.h"
 #include "myio.h"
+#include "responseCache.h"
+#include "retryPolicy.h"
+#include "requestContext.h"
+#include "stats.h"
+#include "streamHandling.h"
+#include "stringBuffer.h"
+#include "summarizer.h"
 
 char *terminalFormattingContext =
-    "\n\n"
     "====================================\n"
     "OUTPUT FORMAT: TERMINAL PLAIN TEXT\n"
     "====================================\n"
@@ -30,149 +46,674 @@ char *terminalFormattingContext =
     "Add blank lines between sections.\n"
     "====================================\n";
 
-// A struct to hold the response from the server
-struct MemoryStruct {
-    char *memory;
-    size_t size;
-};
-
 // This callback function gets called by libcurl as soon as there is data
-// received
+// received, the body is collected in a growable buffer
 static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb,
                                   void *userp) {
     size_t realsize = size * nmemb;
-    struct MemoryStruct *mem = (struct MemoryStruct *)userp;
+    struct StringBuffer *mem = (struct StringBuffer *)userp;
 
-    // Reallocate memory for the response buffer
-    char *ptr = realloc(mem->memory, mem->size + realsize + 1);
-    if (!ptr) {
+    if (!appendToBuffer(mem, contents, realsize)) {
         /* out of memory! */
         printf("not enough memory (realloc returned NULL)\n");
         return 0;
     }
+    return realsize;
+}
 
-    mem->memory = ptr;
-    memcpy(&(mem->memory[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->memory[mem->size] = 0;
+// Options collected from the command line
+struct Options {
+    int streaming;         // use streamGenerateContent and show text early
+    size_t historyBudget;  // tokens of history kept before compacting
+    int summarize;         // fold compacted turns into a running summary
+    int typewriter;        // animate answers in the interactive chat
+    int printStats;        // print a latency breakdown after each answer
+    const char *statsFile; // append the breakdown as JSON lines here
+    const char *endpoint;  // base url overriding ASKAI_ENDPOINT
+    const char *model;     // model overriding ASKAI_MODEL
+    const char *batchFile; // JSONL prompts to answer concurrently, "-" = stdin
+    int concurrency;       // requests in flight in batch mode
+    int ordered;           // print batch results in input order
+    int useCache;          // answer repeated requests from the disk cache
+    long cacheTtl;         // seconds a cached answer stays valid
+    uint64_t cacheBytes;   // disk space the cached answers may take
+    int daemon;            // serve other askai processes instead of asking
+    int useDaemon;         // relay requests through a running daemon
+    int persistConnections; // keep DNS results and TLS sessions on disk
+    int keepPartial;       // keep an interrupted answer in the history
+    int retry;             // retry rate limits, server and network errors
+    long hedgeAfterMs;     // send a second copy of slow requests, see ctx
+    struct StringBuffer question;  // words given after the options
+};
 
-    return realsize;
+// The session whose request is in flight, Ctrl-C cancels it instead of
+// ending the program
+static struct RequestContext *volatile interruptTarget = NULL;
+
+static void handleInterrupt(int sig) {
+    struct RequestContext *ctx = interruptTarget;
+    if (ctx) {
+        cancelRequest(ctx);
+        return;
+    }
+    // At the prompt Ctrl-C still quits as usual
+    signal(sig, SIG_DFL);
+    raise(sig);
 }
 
-char *appendToHistory(char *history, char *role, char *contents) {
-    int historyLen = history ? strlen(history) : 0;
-    int newLen =
-        historyLen + strlen(role) + strlen(contents) + 3;  // +4 for "\n : \0"
+// Everything the network thread needs to perform one request
+struct NetworkJob {
+    struct RequestContext *ctx;
+    const char *post_data;
+    int streaming;
+    ResponseCallback callback;
+    void *userp;  // the stream state or the buffer collecting the body
+    struct TurnStats *stats;
+    CURLcode result;
+    atomic_int done;  // set once the transfer and the stream are finished
+};
+
+// Performs the transfer of a job, on its own thread when streaming so the
+// renderer never holds up the socket
+static void *networkThread(void *arg) {
+    struct NetworkJob *job = arg;
+    if (job->ctx->daemonSocket) {
+        job->result = relayRequest(job->ctx->daemonSocket, job->streaming,
+                                   job->post_data, job->callback, job->userp,
+                                   job->stats, &job->ctx->cancelled);
+    } else {
+        job->result = performRequest(job->ctx, job->post_data, job->callback,
+                                     job->userp);
+        collectTransferStats(job->stats, job->ctx->winner);
+        job->stats->hedged = job->ctx->hedged;
+    }
+    // A last event without a blank line after it still reaches the renderer
+    if (job->result == CURLE_OK && job->streaming)
+        finishStream(job->userp);
+    atomic_store(&job->done, 1);
+    return NULL;
+}
 
-    char *newHistory = realloc(history, newLen);
-    if (!newHistory)
-        return history;
+// Renders the text the network thread queues until its job is done, returns
+// the time spent rendering
+static double renderFromRing(struct ByteRing *ring, struct Renderer *renderer,
+                             struct NetworkJob *job, pthread_t network) {
+    char block[4096];
+    double renderMs = 0;
+    atomic_int *done = &job->done;
+    int signalled = 0;
+    while (1) {
+        // Ctrl-C usually lands on this thread while libcurl sleeps in poll()
+        // on the network thread; passing it on once interrupts that wait so
+        // the abort takes effect at once
+        if (!signalled && atomic_load(&job->ctx->cancelled) &&
+            !atomic_load(done)) {
+            pthread_kill(network, SIGINT);
+            signalled = 1;
+        }
+        // Read before draining, so text queued just before the end is shown
+        int finished = atomic_load(done);
+        size_t n;
+        double start = monotonicMs();
+        while ((n = ringRead(ring, block, sizeof(block))) > 0)
+            renderText(renderer, block, n);
+        flushRender(renderer);
+        renderMs += monotonicMs() - start;
+        if (finished)
+            return renderMs;
+        sleep_ms(RING_POLL_MS);
+    }
+}
 
-    if (historyLen == 0) {
-        newHistory[0] = '\0';  // Initialize empty string
+// Runs a job to completion, streaming through the ring on a network thread
+// when one is given. Returns the time spent rendering.
+static double runNetworkJob(struct NetworkJob *job, struct ByteRing *ring,
+                            struct Renderer *renderer) {
+    atomic_init(&job->done, 0);
+    pthread_t network;
+    if (ring && pthread_create(&network, NULL, networkThread, job) == 0) {
+        double renderMs = renderFromRing(ring, renderer, job, network);
+        pthread_join(network, NULL);
+        return renderMs;
     }
+    // Without a thread the callback renders directly, as it always could
+    struct StreamState *stream = job->streaming ? job->userp : NULL;
+    if (stream)
+        stream->ring = NULL;
+    networkThread(job);
+    return stream ? stream->renderMs : 0;
+}
 
-    strcat(newHistory, "\n");
-    strcat(newHistory, role);
-    strcat(newHistory, ":");
-    strcat(newHistory, contents);
-    return newHistory;
+// helper to wait before a retry in short steps, returns 0 if Ctrl-C cut the
+// wait short
+static int sleepUnlessCancelled(struct RequestContext *ctx, long ms) {
+    for (long waited = 0; waited < ms; waited += RETRY_POLL_MS) {
+        if (atomic_load(&ctx->cancelled))
+            return 0;
+        sleep_ms(RETRY_POLL_MS);
+    }
+    return !atomic_load(&ctx->cancelled);
 }
 
-int main() {
-    CURL *curl_handle;
+// Sends one request body and shows the answer through the renderer as it
+// arrives, recording where the time went in stats. With a cache, an answer
+// already known for the same body is shown without any request. With retry,
+// failures that may be temporary are tried again after a backoff. Ctrl-C
+// aborts the transfer and sets ctx->cancelled. Returns the answer text (only
+// the part received if interrupted), owned by the caller, or NULL if nothing
+// usable came back.
+static char *askModel(struct RequestContext *ctx, const char *post_data,
+                      int streaming, int retry, struct ResponseCache *cache,
+                      struct Renderer *renderer, struct TurnStats *stats) {
     CURLcode res;
+    size_t post_length = strlen(post_data);
+    resetCancel(ctx);
+    char *responseText = cacheLookup(cache, post_data, post_length);
+    if (responseText) {
+        double start = monotonicMs();
+        renderText(renderer, responseText, strlen(responseText));
+        flushRender(renderer);
+        stats->displayMs = monotonicMs() - start;
+        stats->cacheHit = 1;
+        return responseText;
+    }
+
+    // Initialize the struct that will hold our response
+    struct AnswerInfo info;
+    initAnswerInfo(&info);
+    struct StringBuffer chunk;
+    initStringBuffer(&chunk);  // will be grown as needed by the callback
+    // Or, when streaming, the state of the event stream being read. Its
+    // fragments are queued in a ring by the network thread and rendered here,
+    // so a slow terminal or the typing animation never stalls the download.
+    struct ByteRing ring;
+    int threaded = streaming && initByteRing(&ring, STREAM_RING_BYTES);
+    struct StreamState stream;
+    initStreamState(&stream, renderer, threaded ? &ring : NULL);
 
-    const char *api_key = getApiKey();
-    if (!api_key)
+    // A whole body is collected in 'chunk' and parsed at the end
+    struct NetworkJob job;
+    job.ctx = ctx;
+    job.post_data = post_data;
+    job.streaming = streaming;
+    job.callback = streaming ? StreamCallback : WriteMemoryCallback;
+    job.userp = streaming ? (void *)&stream : (void *)&chunk;
+    job.stats = stats;
+
+    interruptTarget = ctx;
+    double renderMs = 0;
+    int interrupted = 0;
+    int retried[FAILURE_SERVER + 1] = {0};  // retries so far, per class
+    while (1) {
+        renderMs = runNetworkJob(&job, threaded ? &ring : NULL, renderer);
+        res = job.result;
+        interrupted = res == CURLE_ABORTED_BY_CALLBACK &&
+                      atomic_load(&ctx->cancelled);
+        if (interrupted || !retry)
+            break;
+
+        // Only a request that showed nothing yet can be sent again, a
+        // stream cut in the middle would repeat the text already printed
+        enum FailureClass failure = classifyFailure(res, stats->httpStatus);
+        if (failure == FAILURE_NONE || stream.text.length > 0)
+            break;
+        curl_off_t retryAfter = 0;
+        if (ctx->winner)
+            curl_easy_getinfo(ctx->winner, CURLINFO_RETRY_AFTER, &retryAfter);
+        long delay = retryDelayMs(failure, retried[failure], (long)retryAfter);
+        if (delay < 0)
+            break;
+        if (res != CURLE_OK)
+            fprintf(stderr, "%s (%s), retrying in %ld ms\n",
+                    failureName(failure), curl_easy_strerror(res), delay);
+        else
+            fprintf(stderr, "%s (HTTP %ld), retrying in %ld ms\n",
+                    failureName(failure), stats->httpStatus, delay);
+        if (!sleepUnlessCancelled(ctx, delay)) {
+            res = CURLE_ABORTED_BY_CALLBACK;
+            interrupted = 1;
+            break;
+        }
+
+        // Start over with empty buffers, the failed body is of no use
+        freeStringBuffer(&chunk);
+        initStringBuffer(&chunk);
+        freeStreamState(&stream);
+        initStreamState(&stream, renderer, threaded ? &ring : NULL);
+        retried[failure]++;
+        stats->retries++;
+    }
+    interruptTarget = NULL;
+    if (threaded)
+        freeByteRing(&ring);
+
+    // Check for errors
+    if (interrupted) {
+        // What was streamed so far is handed back, the caller decides whether
+        // to keep it
+        fprintf(stderr, "\n[interrupted]\n");
+        if (stream.text.length > 0)
+            responseText = detachBuffer(&stream.text);
+        stats->parseMs = stream.parseMs;
+        stats->displayMs = renderMs;
+    } else if (res != CURLE_OK) {
+        fprintf(stderr, "curl_easy_perform() failed: %s\n",
+                curl_easy_strerror(res));
+    } else if (streaming) {
+        if (stream.text.length > 0)
+            responseText = detachBuffer(&stream.text);
+        else if (stats->httpStatus / 100 != 2 && stream.other.length > 0)
+            // The error body is reported like in --no-stream mode
+            free(parse_gemini_response(stream.other.data, NULL));
+        else
+            fprintf(stderr, "No answer received from the server\n");
+        stats->parseMs = stream.parseMs;
+        stats->displayMs = renderMs;
+    } else {
+        // The request was successful, show the response
+        double start = monotonicMs();
+        responseText = parse_gemini_response(chunk.data, &info);
+        double parsed = monotonicMs();
+        if (responseText) {
+            renderText(renderer, responseText, strlen(responseText));
+            flushRender(renderer);
+        }
+        stats->parseMs = parsed - start;
+        stats->displayMs = monotonicMs() - parsed;
+    }
+
+    if (streaming)
+        info = stream.info;
+    stats->promptTokens = info.promptTokens;
+    stats->candidatesTokens = info.candidatesTokens;
+    stats->totalTokens = info.totalTokens;
+    if (responseText && !interrupted)
+        cacheStore(cache, post_data, post_length, responseText,
+                   strlen(responseText), info.finishReason);
+    freeStringBuffer(&chunk);
+    freeStreamState(&stream);
+    return responseText;
+}
+
+// helper to report the stats of a turn wherever the options ask for
+static void reportStats(struct Options *options, struct TurnStats *stats) {
+    if (options->printStats)
+        printTurnStats(stats, stderr);
+    if (options->statsFile && !appendTurnStats(stats, options->statsFile))
+        fprintf(stderr, "Could not write stats to %s\n", options->statsFile);
+}
+
+// helper to tell whether stdin is a pipe or a redirected file, a terminal or
+// an inherited character device is never read in one-shot mode
+static int stdinIsPiped() {
+    struct stat st;
+    if (fstat(STDIN_FILENO, &st) != 0)
         return 0;
+    return S_ISFIFO(st.st_mode) || S_ISREG(st.st_mode) || S_ISSOCK(st.st_mode);
+}
 
-    // Construct the full URL with the API key
-    char url[256];
-    snprintf(url, sizeof(url),
-             "https://generativelanguage.googleapis.com/v1beta/models/"
-             "gemini-2.5-flash-lite:generateContent?key=%s",
-             api_key);
-
-    char *history = malloc(1024);  // Increased buffer size
-    strcpy(history,
-           "CONVERSATION HISTORY:\n"
-           "Below is the complete conversation between user and assistant. "
-           "Maintain context from all previous exchanges. "
-           "user: indicates messages from the user. "
-           "model: indicates your previous responses.\n"
-           "---\n");
+// helper to read everything piped into stdin
+static int readAllStdin(struct StringBuffer *out) {
+    char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), stdin)) > 0) {
+        if (!appendToBuffer(out, block, n))
+            return 0;
+    }
+    return !ferror(stdin);
+}
+
+// One-shot mode: answer a single question from the arguments and/or stdin,
+// print the raw answer to stdout and exit. No banner, no typing animation
+// and no history are set up.
+static int runOneShot(struct RequestContext *ctx, struct Options *options,
+                      struct ResponseCache *cache) {
+    struct StringBuffer prompt;
+    initStringBuffer(&prompt);
+    if (options->question.length > 0)
+        appendToBuffer(&prompt, options->question.data,
+                       options->question.length);
+
+    // Piped input is appended below the question, e.g. git diff | askai ...
+    if (stdinIsPiped()) {
+        struct StringBuffer input;
+        initStringBuffer(&input);
+        if (!readAllStdin(&input)) {
+            fprintf(stderr, "Error reading from stdin\n");
+            freeStringBuffer(&input);
+            freeStringBuffer(&prompt);
+            return 1;
+        }
+        if (input.length > 0) {
+            if (prompt.length > 0)
+                appendToBuffer(&prompt, "\n\n", 2);
+            appendToBuffer(&prompt, input.data, input.length);
+        }
+        freeStringBuffer(&input);
+    }
+    if (prompt.length == 0) {
+        fprintf(stderr, "Nothing to ask: the question is empty\n");
+        freeStringBuffer(&prompt);
+        return 1;
+    }
+
+    struct TurnStats stats;
+    initTurnStats(&stats);
+    double start = monotonicMs();
+    struct ChatHistory request;
+    initHistory(&request);
+    addTurn(&request, "user", prompt.data);
+    const char *post_data = preparePostData(&request, terminalFormattingContext);
+    stats.prepareMs = monotonicMs() - start;
+
+    struct Renderer renderer;
+    initRenderer(&renderer, 0);
+    char *responseText =
+        askModel(ctx, post_data, options->streaming, options->retry, cache,
+                 &renderer, &stats);
+
+    // Finish the output with a newline so shell prompts start on a new line
+    if (responseText && responseText[0] &&
+        responseText[strlen(responseText) - 1] != '\n')
+        putchar('\n');
+    fflush(stdout);
+    reportStats(options, &stats);
+
+    // Like any command stopped by Ctrl-C, exit with 128 + SIGINT
+    int status = atomic_load(&ctx->cancelled) ? 130 : responseText ? 0 : 1;
+    free(responseText);
+    free((void *)post_data);
+    freeHistory(&request);
+    freeStringBuffer(&prompt);
+    return status;
+}
+
+// Interactive mode: the chat loop with history, compaction and the typing
+// animation
+static void runChat(struct RequestContext *ctx, struct Options *options,
+                    const struct ApiConfig *config,
+                    struct ResponseCache *cache) {
+    // Every exchange is kept as separate turns and resent as contents
+    struct ChatHistory history;
+    initHistory(&history);
+
+    // Turns dropped by compaction wait here until the summarizer is free
+    struct StringBuffer dropped;
+    initStringBuffer(&dropped);
+    struct Summarizer summarizer;
+    size_t summaryWords = options->historyBudget / 10;
+    if (summaryWords < 50)
+        summaryWords = 50;
+    if (summaryWords > 1000)
+        summaryWords = 1000;
+    initSummarizer(&summarizer, config, summaryWords);
 
     printf(
         "Welcome to AskAI Chat. Get answers to your question. (type \"stop\" "
         "and press enter to exit )");
     while (1) {
-        // Initialize the struct that will hold our response
-        struct MemoryStruct chunk;
-        chunk.memory = malloc(1);  // will be grown as needed by the callback
-        chunk.size = 0;            // no data at this point
-
         printf("\n");
+        // Connect (or check the connection is still alive) while the user is
+        // typing, the request then goes out on an established connection
+        startWarmup(ctx);
         char *userPrompt = readString();
-        // Check if user wants to stop
-        if (strcmp(userPrompt, "stop") == 0) {
+        // Check if user wants to stop, end of input counts as stop too
+        if (!userPrompt || strcmp(userPrompt, "stop") == 0) {
             printf("Exiting AskAI CLI. Goodbye!\n");
             free(userPrompt);
             break;
         }
 
-        history = appendToHistory(history, "user", userPrompt);
+        struct TurnStats stats;
+        initTurnStats(&stats);
+        double start = monotonicMs();
+        addTurn(&history, "user", userPrompt);
+
+        // Keep the payload size roughly constant: pick up a summary finished
+        // in the background, then drop the oldest turns that do not fit
+        char *summary = takeSummary(&summarizer, &dropped);
+        if (summary)
+            setHistorySummary(&history, summary);
+        compactHistory(&history, options->historyBudget,
+                       options->summarize ? &dropped : NULL);
+        if (dropped.length > 0 &&
+            startSummary(&summarizer, history.summary, dropped.data))
+            clearBuffer(&dropped);
+
         const char *post_data =
-            preparePostData(userPrompt, terminalFormattingContext, history);
-        // Initialize libcurl globally
-        curl_global_init(CURL_GLOBAL_ALL);
+            preparePostData(&history, terminalFormattingContext);
+        stats.prepareMs = monotonicMs() - start;
+
+        printf("\n");
+        struct Renderer renderer;
+        initRenderer(&renderer, options->typewriter);
+        char *responseText =
+            askModel(ctx, post_data, options->streaming, options->retry, cache,
+                     &renderer, &stats);
+        reportStats(options, &stats);
+
+        // A prompt that got no answer is dropped so the turns keep alternating,
+        // an interrupted answer too unless --keep-partial asks to keep it
+        int keep = responseText && (!atomic_load(&ctx->cancelled) ||
+                                    options->keepPartial);
+        if (keep)
+            addTurn(&history, "model", responseText);
+        else
+            removeLastTurn(&history);
+
+        // Cleanup
+        free(responseText);
+        free((void *)post_data);
+        free(userPrompt);
+    }
+
+    stopSummarizer(&summarizer);
+    freeStringBuffer(&dropped);
+    freeHistory(&history);
+}
+
+int main(int argc, char *argv[]) {
+    struct RequestContext ctx;
+    struct Options options;
 
-        // Initialize a curl easy handle
-        curl_handle = curl_easy_init();
-        if (curl_handle) {
-            // Set the required headers
-            struct curl_slist *headers = NULL;
-            headers =
-                curl_slist_append(headers, "Content-Type: application/json");
-
-            // Set the curl options
-            curl_easy_setopt(curl_handle, CURLOPT_URL, url);
-            curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
-            curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, post_data);
-            // Set the callback function to handle the response
-            curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION,
-                             WriteMemoryCallback);
-            // Pass our 'chunk' struct to the callback function
-            curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)&chunk);
-
-            // Perform the request, res will get the return code
-            res = curl_easy_perform(curl_handle);
-
-            // Check for errors
-            if (res != CURLE_OK) {
-                fprintf(stderr, "curl_easy_perform() failed: %s\n",
-                        curl_easy_strerror(res));
+    // Answers are streamed by default, --no-stream waits for the full body
+    options.streaming = 1;
+    // Older turns are compacted once the history exceeds this many tokens
+    options.historyBudget = DEFAULT_HISTORY_TOKENS;
+    options.summarize = 1;
+    // Answers are revealed with a short typing animation unless disabled
+    options.typewriter = 1;
+    options.printStats = 0;
+    options.statsFile = NULL;
+    options.endpoint = NULL;
+    options.model = NULL;
+    options.batchFile = NULL;
+    options.concurrency = DEFAULT_BATCH_CONCURRENCY;
+    options.ordered = 1;
+    // The response cache is opt-in, answers can change between requests
+    options.useCache = 0;
+    options.cacheTtl = DEFAULT_CACHE_TTL;
+    options.cacheBytes = DEFAULT_CACHE_BYTES;
+    options.daemon = 0;
+    options.useDaemon = 1;
+    options.persistConnections = 1;
+    options.keepPartial = 0;
+    // Temporary failures are retried, slow requests are not hedged unless
+    // asked for since a hedge can double the tokens billed
+    options.retry = 1;
+    options.hedgeAfterMs = 0;
+    initStringBuffer(&options.question);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-stream") == 0) {
+            options.streaming = 0;
+        } else if (strcmp(argv[i], "--history-tokens") == 0 && i + 1 < argc) {
+            options.historyBudget = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--no-summary") == 0) {
+            options.summarize = 0;
+        } else if (strcmp(argv[i], "--no-typewriter") == 0) {
+            options.typewriter = 0;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options.printStats = 1;
+        } else if (strcmp(argv[i], "--stats-file") == 0 && i + 1 < argc) {
+            options.statsFile = argv[++i];
+        } else if (strcmp(argv[i], "--endpoint") == 0 && i + 1 < argc) {
+            options.endpoint = argv[++i];
+        } else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            options.model = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            options.batchFile = argv[++i];
+        } else if (strcmp(argv[i], "--concurrency") == 0 && i + 1 < argc) {
+            char *end;
+            long concurrency = strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || concurrency < 1 ||
+                concurrency > MAX_BATCH_CONCURRENCY) {
+                fprintf(stderr, "--concurrency must be a number from 1 to %d\n",
+                        MAX_BATCH_CONCURRENCY);
+                return 1;
+            }
+            options.concurrency = (int)concurrency;
+        } else if (strcmp(argv[i], "--order") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "input") == 0) {
+                options.ordered = 1;
+            } else if (strcmp(argv[i], "completion") == 0) {
+                options.ordered = 0;
             } else {
-                // The request was successful, print the response
-                char *responseText = parse_gemini_response(chunk.memory);
-                printf("\n");
-                displayStringWithDelay(responseText);
-                history = appendToHistory(history, "model", responseText);
+                fprintf(stderr, "--order must be input or completion\n");
+                return 1;
             }
-
-            // Cleanup
-            curl_slist_free_all(headers);
-            curl_easy_cleanup(curl_handle);
-            free(chunk.memory);
-            free((void *)post_data);
-            free(userPrompt);
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            options.useCache = 1;
+        } else if (strcmp(argv[i], "--cache-ttl") == 0 && i + 1 < argc) {
+            options.useCache = 1;
+            options.cacheTtl = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+            // given in megabytes
+            options.useCache = 1;
+            options.cacheBytes = strtoull(argv[++i], NULL, 10) * 1024 * 1024;
+        } else if (strcmp(argv[i], "--daemon") == 0) {
+            options.daemon = 1;
+        } else if (strcmp(argv[i], "--no-daemon") == 0) {
+            options.useDaemon = 0;
+        } else if (strcmp(argv[i], "--keep-partial") == 0) {
+            options.keepPartial = 1;
+        } else if (strcmp(argv[i], "--no-retry") == 0) {
+            options.retry = 0;
+        } else if (strcmp(argv[i], "--hedge") == 0) {
+            options.hedgeAfterMs = HEDGE_AUTO;
+        } else if (strcmp(argv[i], "--hedge-after") == 0 && i + 1 < argc) {
+            options.hedgeAfterMs = strtol(argv[++i], NULL, 10);
+            if (options.hedgeAfterMs <= 0) {
+                fprintf(stderr, "--hedge-after must be a positive number\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--no-connection-cache") == 0) {
+            options.persistConnections = 0;
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
         } else {
-            printf("Failed due to some network related error");
-            break;
+            // Everything else is part of a one-shot question
+            if (options.question.length > 0)
+                appendToBuffer(&options.question, " ", 1);
+            appendStringToBuffer(&options.question, argv[i]);
         }
     }
+    int oneShot = options.question.length > 0 || stdinIsPiped();
+
+    // The endpoint comes from the environment unless given on the command line
+    struct ApiConfig config;
+    initApiConfig(&config, NULL);
+    if (options.endpoint)
+        config.baseUrl = options.endpoint;
+    if (options.model)
+        config.model = options.model;
+
+    char socketPath[1024];
+    int haveSocket = daemonSocketPath(socketPath, sizeof(socketPath));
+    if (options.daemon) {
+        if (!haveSocket) {
+            fprintf(stderr, "Error: Daemon socket path too long.\n");
+            return 1;
+        }
+        config.apiKey = getApiKey();
+        if (!config.apiKey)
+            return 1;
+        curl_global_init(CURL_GLOBAL_ALL);
+        // The daemon serves one client at a time, so its handles can share
+        // connections as well
+        struct ConnectionCache connections;
+        if (options.persistConnections && openConnectionCache(&connections, 1))
+            config.connections = &connections;
+        int served = runDaemon(socketPath, &config);
+        if (config.connections)
+            closeConnectionCache(config.connections);
+        curl_global_cleanup();
+        return served ? 0 : 1;
+    }
+
+    // A running daemon already holds the key and warm connections, so a
+    // one-shot question skips loading them. The chat still needs them for the
+    // background summarizer. The daemon serves one request at a time, so
+    // hedged requests go out directly.
+    int relay = !options.batchFile && options.useDaemon &&
+                options.hedgeAfterMs == 0 && haveSocket &&
+                daemonAvailable(socketPath, &config);
+    struct ConnectionCache connections;
+    if (!relay || !oneShot) {
+        config.apiKey = getApiKey();
+        if (!config.apiKey)
+            return 1;
+        curl_global_init(CURL_GLOBAL_ALL);
+        // Resolved addresses and TLS sessions of earlier runs, shared with the
+        // summarizer thread and the batch handles
+        if (options.persistConnections && openConnectionCache(&connections, 0))
+            config.connections = &connections;
+    }
+
+    // Answers are only looked up and stored when the cache could be opened
+    struct ResponseCache cache;
+    cache.enabled = 0;
+    if (options.useCache)
+        openResponseCache(&cache, &config, options.cacheTtl,
+                          options.cacheBytes);
+
+    // Ctrl-C during a request only cancels that request
+    struct sigaction interrupt;
+    memset(&interrupt, 0, sizeof(interrupt));
+    interrupt.sa_handler = handleInterrupt;
+    interrupt.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &interrupt, NULL);
+
+    // Open one handle for the whole session, or just remember the daemon
+    int status = 0;
+    if (relay) {
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.daemonSocket = socketPath;
+    }
+    if (options.batchFile) {
+        // Batch mode drives its own pool of handles
+        int failed = runBatch(&config, options.batchFile, options.concurrency,
+                              options.ordered, &cache);
+        status = failed == 0 ? 0 : 1;
+    } else if (!relay &&
+               !initRequestContext(&ctx, &config, options.streaming)) {
+        fprintf(stderr, "Failed due to some network related error\n");
+        status = 1;
+    } else {
+        ctx.hedgeAfterMs = options.hedgeAfterMs;
+        if (oneShot)
+            status = runOneShot(&ctx, &options, &cache);
+        else
+            runChat(&ctx, &options, &config, &cache);
+        cleanupRequestContext(&ctx);
+    }
 
     // Global cleanup
+    closeResponseCache(&cache);
+    if (config.connections)
+        closeConnectionCache(config.connections);
+    freeStringBuffer(&options.question);
     curl_global_cleanup();
-    return 0;
-}
\ No newline at end of file
+    return status;
+}
@@ -0,0 +1,23 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include "requestContext.h"
+#include "responseCache.h"
+
+// Concurrent requests used when --concurrency is not given
+#define DEFAULT_BATCH_CONCURRENCY 8
+// Most concurrent requests --concurrency accepts
+#define MAX_BATCH_CONCURRENCY 256
+
+// function to answer every prompt of a JSONL file (or stdin for "-") with up
+// to concurrency requests in flight over a shared curl multi handle. Each
+// input line is {"id": ..., "prompt": "..."} (id optional, "text" is
+// accepted for "prompt") or a JSON string.
+// One JSON line per prompt is written to stdout, in input order when ordered
+// is set and in completion order otherwise; its "line" is the line of the
+// input the prompt came from. concurrency must be at least 1. Returns the
+// number of prompts that failed, or -1 if the input could not be read or the
+// requests could not be set up. Prompts found in the cache are answered
+// without a request.
+int runBatch(const struct ApiConfig *config, const char *path,
+             int concurrency, int ordered, struct ResponseCache *cache);
+#endif
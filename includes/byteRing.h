@@ -0,0 +1,32 @@
+#ifndef BYTERING_H
+#define BYTERING_H
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Bytes of answer text the network thread may get ahead of the renderer
+#define STREAM_RING_BYTES (256 * 1024)
+
+// Lock-free single-producer single-consumer ring of bytes. One thread writes,
+// one other thread reads; head and tail only ever grow and are reduced
+// modulo the capacity, which is a power of two.
+struct ByteRing {
+    char *data;
+    size_t capacity;
+    atomic_size_t head;  // total bytes written, only changed by the producer
+    atomic_size_t tail;  // total bytes read, only changed by the consumer
+};
+
+// function to allocate a ring of at least capacity bytes, returns 0 if out
+// of memory
+int initByteRing(struct ByteRing *ring, size_t capacity);
+
+// function for the producer to add bytes, returns how many fit
+size_t ringWrite(struct ByteRing *ring, const char *data, size_t length);
+
+// function for the consumer to take up to length bytes, returns how many
+// were available
+size_t ringRead(struct ByteRing *ring, char *out, size_t length);
+
+// function to release the buffer of the ring
+void freeByteRing(struct ByteRing *ring);
+#endif
@@ -122,6 +122,9 @@ typedef struct cJSON
     char *string;
 } cJSON;
 
+/* A pool of slabs that the nodes and strings of parsed documents are carved from. */
+typedef struct cJSON_Pool cJSON_Pool;
+
 typedef struct cJSON_Hooks
 {
       /* malloc/free are CDECL on Windows regardless of the default calling convention of the compiler, so ensure the hooks allow passing those functions directly. */
@@ -158,12 +161,31 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
 
+/* Pooled parsing: nodes come from cache line aligned slabs and strings are packed into shared blocks, so a document costs a handful of allocations instead of several per value. */
+/* Documents parsed into a pool are released all at once with cJSON_ResetPool or cJSON_DeletePool. They must never be passed to cJSON_Delete, nor have items added, replaced or detached. */
+CJSON_PUBLIC(cJSON_Pool *) cJSON_CreatePool(void);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithPool(cJSON_Pool *pool, const char *value, size_t buffer_length);
+/* Release every document of the pool, the slabs are kept and reused by the next parse. */
+CJSON_PUBLIC(void) cJSON_ResetPool(cJSON_Pool *pool);
+CJSON_PUBLIC(void) cJSON_DeletePool(cJSON_Pool *pool);
+
+/* Destructive parse: strings and names are unescaped inside value, which is overwritten, and valuestring/string point into it instead of into copies. */
+/* value must outlive the document, and the strings can't be changed with cJSON_SetValuestring. cJSON_Delete frees only the nodes. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length);
+
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. */
 CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item);
 /* Render a cJSON entity to text using a buffered strategy. prebuffer is a guess at the final size. guessing well reduces reallocation. fmt=0 gives unformatted, =1 gives formatted */
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt);
+/* Length of the text cJSON_Print (format=1) or cJSON_PrintUnformatted (format=0) would produce, without the terminating zero. Returns 0 if the item can't be printed. */
+/* A buffer of this length plus 5 bytes is always enough for cJSON_PrintPreallocated. */
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool format);
+/* Escape length bytes of string as the inside of a JSON string (no quotes) with the same rules as the printer, for writing JSON without a tree. */
+/* cJSON_EscapedLength measures the result, cJSON_WriteEscaped writes it to output, which must have that much room, and returns the position right after it. */
+CJSON_PUBLIC(size_t) cJSON_EscapedLength(const char *string, size_t length);
+CJSON_PUBLIC(char *) cJSON_WriteEscaped(char *output, const char *string, size_t length);
 /* Render a cJSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
 /* NOTE: cJSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format);
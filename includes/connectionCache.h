@@ -0,0 +1,44 @@
+#ifndef CONNECTIONCACHE_H
+#define CONNECTIONCACHE_H
+#include <curl/curl.h>
+#include <pthread.h>
+#include <time.h>
+
+// Resolved addresses are reused from the file for this many seconds
+#define CONNECTION_DNS_TTL 300
+
+// DNS results and TLS sessions shared by every handle of the process through
+// a libcurl share object and persisted to ~/.askai-cli/connections, so the
+// next invocation can skip the lookup and resume the TLS session. Sessions
+// can only be exported with libcurl 8.12 or newer, older versions persist the
+// addresses only.
+struct ConnectionCache {
+    CURLSH *share;
+    pthread_mutex_t locks[CURL_LOCK_DATA_LAST];  // one per kind of shared data
+    pthread_mutex_t mutex;                       // guards the fields below
+    char path[1024];
+    struct curl_slist *resolve;  // loaded "+host:port:address" entries
+    char host[256];              // last endpoint that answered
+    long port;
+    char address[64];
+    time_t resolvedAt;
+    int dirty;  // the address changed and has to be written back
+};
+
+// function to create the share object and load the persisted entries,
+// connection sharing is only safe when all handles live on one thread at a
+// time. Returns 0 if libcurl could not create the share.
+int openConnectionCache(struct ConnectionCache *cache, int shareConnections);
+
+// function to attach a handle to the shared caches and preload the persisted
+// addresses into it
+void applyConnectionCache(struct ConnectionCache *cache, CURL *curl);
+
+// function to note the address (and with a new enough libcurl the TLS
+// sessions) used by the last transfer of the handle
+void rememberConnection(struct ConnectionCache *cache, CURL *curl);
+
+// function to write the entries back if they changed and release the share,
+// every handle using it must have been cleaned up before
+void closeConnectionCache(struct ConnectionCache *cache);
+#endif
@@ -0,0 +1,35 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+#include <curl/curl.h>
+#include <stdatomic.h>
+
+#include "requestContext.h"
+#include "stats.h"
+
+// A running `askai --daemon` holds the api config and warm connections to the
+// endpoint and performs requests on behalf of short lived askai processes.
+// Clients talk to it over a Unix domain socket in ~/.askai-cli; the response
+// body is relayed back unchanged, so the client parses it exactly as if it
+// had made the request itself.
+
+// function to build the path of the daemon socket, returns 0 if it does not
+// fit or HOME is not set
+int daemonSocketPath(char *path, size_t size);
+
+// function to check that a daemon is listening on path and serves the same
+// endpoint and model as config
+int daemonAvailable(const char *path, const struct ApiConfig *config);
+
+// function to have the daemon send one request body and feed the response to
+// callback as it arrives. The network timings and byte counts measured by the
+// daemon are copied into stats. Setting cancel hangs up, which also aborts
+// the daemon's transfer, and returns CURLE_ABORTED_BY_CALLBACK.
+CURLcode relayRequest(const char *path, int streaming, const char *post_data,
+                      ResponseCallback callback, void *userp,
+                      struct TurnStats *stats, atomic_int *cancel);
+
+// function to serve requests on path until SIGINT or SIGTERM, one client at a
+// time. The connection cache of config, if any, should share connections.
+// Returns 0 if the socket could not be set up.
+int runDaemon(const char *path, const struct ApiConfig *config);
+#endif
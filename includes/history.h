@@ -0,0 +1,57 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+#include <stddef.h>
+
+#include "stringBuffer.h"
+
+// Token budget used when none is given on the command line
+#define DEFAULT_HISTORY_TOKENS 32000
+
+// One message of the conversation, role is "user" or "model" as expected by
+// the Gemini contents array
+struct Turn {
+    char *role;
+    char *text;
+    size_t length;  // strlen(text), kept so it never has to be recounted
+    size_t tokens;  // estimated tokens of the turn, including role framing
+    char *entry;    // the turn already rendered as a JSON contents entry
+    size_t entryLength;
+};
+
+// The conversation so far, oldest turn first. The turn array grows
+// geometrically so appending a turn is amortized O(1).
+struct ChatHistory {
+    struct Turn *turns;
+    int count;
+    int capacity;
+    size_t tokens;         // sum of the estimated tokens of all turns
+    char *summary;         // running summary of turns that were compacted away
+    size_t summaryTokens;  // estimated tokens of the summary
+};
+
+// function to prepare an empty history
+void initHistory(struct ChatHistory *history);
+
+// function to append a copy of a message to the history, returns 0 on failure
+int addTurn(struct ChatHistory *history, const char *role, const char *text);
+
+// function to forget the most recent turn, used when a request fails
+void removeLastTurn(struct ChatHistory *history);
+
+// function to release every turn of the history
+void freeHistory(struct ChatHistory *history);
+
+// function to cheaply estimate how many tokens a text will cost, without a
+// round trip to the countTokens endpoint
+size_t estimateTokens(const char *text, size_t length);
+
+// function to drop the oldest exchanges until the history and its summary fit
+// in budget tokens. The dropped turns are appended to dropped as
+// "role: text" lines so they can be summarized, returns the number of
+// dropped turns. The most recent turn is always kept.
+int compactHistory(struct ChatHistory *history, size_t budget,
+                   struct StringBuffer *dropped);
+
+// function to replace the running summary, the history takes ownership of it
+void setHistorySummary(struct ChatHistory *history, char *summary);
+#endif
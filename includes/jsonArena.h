@@ -0,0 +1,42 @@
+#ifndef JSONARENA_H
+#define JSONARENA_H
+#include <stddef.h>
+
+// Size of the first block of an arena, later blocks double up to big enough
+// for the request that needed them
+#define JSON_ARENA_BLOCK (64 * 1024)
+
+struct ArenaBlock;
+
+// Bump allocator for the short-lived cJSON work of one request. While an
+// arena is active on a thread, every cJSON allocation made by that thread
+// is carved out of its blocks and freeing is (nearly) free; everything is
+// released at once by resetJsonArena. Used around the parse of each batch
+// input line.
+struct JsonArena {
+    struct ArenaBlock *blocks;  // newest first
+    size_t allocations;         // served since the arena was created
+    size_t bytes;               // in use right now
+};
+
+// function to prepare an empty arena, no memory is allocated until the
+// first allocation
+void initJsonArena(struct JsonArena *arena);
+
+// function to send the cJSON allocations of the calling thread to the arena
+// until endJsonArena. This installs cJSON's process wide hooks, so no other
+// thread may use cJSON until endJsonArena.
+void beginJsonArena(struct JsonArena *arena);
+
+// function to go back to malloc and restore cJSON's default hooks. Trees
+// built in the arena stay readable until the reset but must never be passed
+// to cJSON_Delete afterwards.
+void endJsonArena();
+
+// function to drop everything allocated in the arena at once, the largest
+// block is kept for the next request
+void resetJsonArena(struct JsonArena *arena);
+
+// function to release all the memory of the arena
+void freeJsonArena(struct JsonArena *arena);
+#endif
@@ -1,14 +1,30 @@
 #ifndef JSONHANDLING_H
 #define JSONHANDLING_H
+#include "history.h"
+
+// What an answer reports besides its text
+struct AnswerInfo {
+    char finishReason[32];  // of the first candidate, empty if not reported
+    // From usageMetadata, -1 if not reported
+    long promptTokens;
+    long candidatesTokens;
+    long totalTokens;
+};
+
+// function to reset the info before the answer is parsed
+void initAnswerInfo(struct AnswerInfo *info);
 
 
 //helper function to actually create a stringified json object that needs to be posted
 char *create_gemini_json_payload(const char *prompt_text);
 
 
-//function to prepare the exact prompt data to be sent to gemini api by combining prompt, history and context
-const char *preparePostData(char *userPrompt, char *extraContext, char *history);
+//function to prepare the exact request body to be sent to gemini api, one contents entry per turn of the history plus the system instruction
+const char *preparePostData(const struct ChatHistory *history, const char *systemInstruction);
+
+//function to extract and return the text part of the response from gemini api, the rest of the answer goes into info unless it is NULL
+char *parse_gemini_response(const char *response_json, struct AnswerInfo *info);
 
-//function to extract and return the text part of the response from gemini api
-char *parse_gemini_response(const char *response_json);
+//function to extract the text fragment carried by one streamed chunk, returns NULL if the chunk has no text. What the chunk reports besides text is updated in info unless it is NULL.
+char *parse_gemini_chunk(const char *chunk_json, struct AnswerInfo *info);
 #endif
\ No newline at end of file
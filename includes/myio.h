@@ -1,12 +1,41 @@
 #ifndef MYIO_H
-#define MTIO_H
+#define MYIO_H
+#include <stddef.h>
+
+// Time between two flushes of the renderer, about 60 frames per second
+#define RENDER_FRAME_MS 16
+// How often the renderer checks for text queued by the network thread
+#define RING_POLL_MS 2
+// Bytes revealed per frame by the typewriter effect
+#define TYPEWRITER_CHARS_PER_FRAME 6
+// Longest time the typewriter effect may spend on a single answer
+#define TYPEWRITER_BUDGET_MS 1500
+
+// Collects answer text and writes it to stdout in whole chunks, flushing at
+// most once per frame. The optional typewriter effect reveals the text a few
+// characters per frame until its time budget for the answer is used up.
+struct Renderer {
+    int typewriter;
+    long animatedMs;  // time already spent animating the current answer
+    long long lastFlushMs;
+    size_t pending;   // bytes written since the last flush
+};
 
 //helper function to pause the printing for some time
 void sleep_ms(long milliseconds);
 
+//function to prepare a renderer, the typewriter effect is only used when stdout is a terminal
+void initRenderer(struct Renderer *renderer, int typewriter);
+
+//function to output a piece of text, flushing only when a frame is due
+void renderText(struct Renderer *renderer, const char *text, size_t length);
+
+//function to push out anything still buffered by the renderer
+void flushRender(struct Renderer *renderer);
+
 //function to display output with delays in between to simulate chatbot like response
 void displayStringWithDelay(char *str);
 
 //function to read a variable length string from user and return it.
 char *readString();
-#endif
\ No newline at end of file
+#endif
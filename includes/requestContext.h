@@ -0,0 +1,108 @@
+#ifndef REQUESTCONTEXT_H
+#define REQUESTCONTEXT_H
+#include <curl/curl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "retryPolicy.h"
+
+// Endpoint used when neither --endpoint nor ASKAI_ENDPOINT is given
+#define DEFAULT_API_BASE "https://generativelanguage.googleapis.com/v1beta"
+// Model used when neither --model nor ASKAI_MODEL is given
+#define DEFAULT_MODEL "gemini-2.5-flash-lite"
+
+struct ConnectionCache;
+
+// Where requests go and how they are authenticated
+struct ApiConfig {
+    const char *apiKey;
+    const char *baseUrl;  // e.g. DEFAULT_API_BASE or a local mock server
+    const char *model;
+    // DNS and TLS state shared by every handle, NULL to not share anything
+    struct ConnectionCache *connections;
+};
+
+// Signature shared by every libcurl write callback used for responses
+typedef size_t (*ResponseCallback)(void *contents, size_t size, size_t nmemb,
+                                   void *userp);
+
+// hedgeAfterMs value that derives the threshold from the session's latencies
+#define HEDGE_AUTO (-1L)
+
+// Long lived state for talking to the Gemini API, created once per session so
+// that every turn reuses the same handle and therefore the same connection
+struct RequestContext {
+    CURL *curl;
+    CURLM *multi;  // drives every transfer, its pool keeps the connections
+    CURL *hedge;   // second handle for hedged requests, made on first use
+    CURL *winner;  // handle whose response the last request delivered
+    int hedged;    // the last request started a hedge
+    // Send a copy of a request that got no answer after this long and use
+    // whichever answers first: 0 never, HEDGE_AUTO at the p95 first byte time
+    long hedgeAfterMs;
+    struct LatencyTracker latency;  // first byte times of the session
+    struct curl_slist *headers;
+    char url[512];
+    // When set, requests are relayed through `askai --daemon` listening on
+    // this socket and curl stays NULL
+    const char *daemonSocket;
+    struct ConnectionCache *connections;  // from the api config, may be NULL
+    char warmUrl[512];  // base url without the key, target of the warm-up
+    pthread_t warmer;
+    int warming;        // a warm-up thread is using curl until it is joined
+    atomic_int cancelWarmup;  // set to abandon a warm-up nobody waits for
+    atomic_int cancelled;     // set (e.g. on Ctrl-C) to abort the request
+    // Asked along with cancelled while a request runs, a non-zero answer
+    // aborts it too. NULL unless set after initRequestContext.
+    int (*abortCheck)(void *arg);
+    void *abortArg;
+};
+
+// function to fill in the api config from the environment, falling back to
+// the defaults for anything not set
+void initApiConfig(struct ApiConfig *config, const char *api_key);
+
+// function to build the url of a model method such as "generateContent" into
+// url, returns 0 if it does not fit
+int buildApiUrl(const struct ApiConfig *config, const char *method, char *url,
+                size_t size);
+
+// function to apply the options every API request shares (url, headers,
+// keep-alive, TCP_NODELAY, HTTP/2) to an easy handle
+void configureApiHandle(CURL *curl, struct curl_slist *headers,
+                        const char *url);
+
+// function to set up the handle, headers and endpoint url for the session and
+// attach it to the connection cache of the config, returns 0 on failure
+int initRequestContext(struct RequestContext *ctx,
+                       const struct ApiConfig *config, int streaming);
+
+// function to send one request body on the session handle, the response is
+// handed to the given write callback and the address used is remembered in
+// the connection cache. The request may be hedged, see hedgeAfterMs; the
+// handle that answered is left in ctx->winner for its timers. Returns
+// CURLE_ABORTED_BY_CALLBACK if cancelRequest was called before or during the
+// transfer.
+CURLcode performRequest(struct RequestContext *ctx, const char *post_data,
+                        ResponseCallback callback, void *userp);
+
+// function to abort the request in flight, if any, as soon as libcurl next
+// reports progress. Async-signal-safe, meant to be called from a handler.
+void cancelRequest(struct RequestContext *ctx);
+
+// function to clear a previous cancellation before the next request
+void resetCancel(struct RequestContext *ctx);
+
+// function to open (or refresh) the connection to the endpoint in the
+// background with a HEAD request, so the next request does not wait for
+// DNS, TCP and TLS. The handle must not be touched until finishWarmup.
+void startWarmup(struct RequestContext *ctx);
+
+// function to wait for a running warm-up and get the handle ready for
+// requests again, called by performRequest itself
+void finishWarmup(struct RequestContext *ctx);
+
+// function to release the handle and header list of the session, a warm-up
+// still in progress is cancelled
+void cleanupRequestContext(struct RequestContext *ctx);
+#endif
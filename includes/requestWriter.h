@@ -0,0 +1,25 @@
+#ifndef REQUESTWRITER_H
+#define REQUESTWRITER_H
+#include <stddef.h>
+
+#include "stringBuffer.h"
+
+// Writes request JSON directly into exactly sized buffers instead of going
+// through a cJSON tree. Strings are escaped by cJSON_EscapedLength and
+// cJSON_WriteEscaped, the same code the cJSON printer uses.
+
+// function to copy length bytes of literal JSON syntax to out, returns the
+// position right after them
+char *writeLiteral(char *out, const char *literal, size_t length);
+
+// function to append text to buf as a complete quoted JSON string, returns 0
+// when out of memory
+int appendJsonString(struct StringBuffer *buf, const char *text,
+                     size_t length);
+
+// function to render one {"role":...,"parts":[{"text":...}]} contents entry
+// into a new buffer of exactly the right size, role may be NULL. The length
+// is stored in entryLength, the caller frees the result.
+char *renderContentEntry(const char *role, const char *text, size_t length,
+                         size_t *entryLength);
+#endif
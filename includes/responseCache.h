@@ -0,0 +1,60 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+#include <stddef.h>
+#include <stdint.h>
+
+#include "requestContext.h"
+
+// Entries older than this many seconds are not served when --cache-ttl is
+// not given
+#define DEFAULT_CACHE_TTL (24 * 60 * 60)
+// Size the cached answers may take on disk when --cache-size is not given
+#define DEFAULT_CACHE_BYTES (64 * 1024 * 1024)
+
+// One cached answer, the answer itself lives in a file named after the key
+struct CacheRecord {
+    uint64_t key[2];  // 128-bit hash of endpoint, model and request body
+    int64_t stored;   // unix time the answer was written
+    uint32_t size;    // bytes of answer text
+    uint32_t unused;  // keeps the record 32 bytes on every platform
+};
+
+// On-disk cache of answers under ~/.askai-cli/cache. The index of all records
+// is loaded once, kept sorted by key and rewritten by closeResponseCache,
+// so a lookup is a binary search plus one small file read.
+struct ResponseCache {
+    int enabled;
+    char dir[1024];
+    const struct ApiConfig *config;  // must outlive the cache
+    struct CacheRecord *records;
+    size_t count;
+    size_t capacity;
+    uint64_t totalBytes;
+    long ttl;
+    uint64_t maxBytes;
+    int dirty;  // the index changed and has to be written back
+};
+
+// function to open (and create if needed) the cache directory and load its
+// index. Returns 0 and leaves the cache disabled if it cannot be used.
+int openResponseCache(struct ResponseCache *cache,
+                      const struct ApiConfig *config, long ttl,
+                      uint64_t maxBytes);
+
+// function to look up the answer to a request body, returns a copy owned by
+// the caller or NULL on a miss or an expired entry
+char *cacheLookup(struct ResponseCache *cache, const char *body,
+                  size_t length);
+
+// function to remember the answer to a request body. Only answers that
+// finished with finishReason STOP are kept, a truncated answer (MAX_TOKENS,
+// SAFETY, ...) or one that reported no reason is not stored.
+void cacheStore(struct ResponseCache *cache, const char *body, size_t length,
+                const char *text, size_t textLength, const char *finishReason);
+
+// function to evict expired and oldest entries down to the size limit, write
+// the index back if it changed and release the cache. The index is rebuilt
+// from the answer files under a lock first, so answers stored by other
+// processes are never left out of it.
+void closeResponseCache(struct ResponseCache *cache);
+#endif
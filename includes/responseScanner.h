@@ -0,0 +1,37 @@
+#ifndef RESPONSESCANNER_H
+#define RESPONSESCANNER_H
+#include <stddef.h>
+
+// Most candidates we keep from one response, Gemini returns 1 by default
+#define MAX_SCANNED_CANDIDATES 8
+
+// Text and finish reason of one candidate, the text of all of its parts is
+// joined together
+struct GeminiCandidate {
+    char *text;  // NULL if the candidate carried no text
+    size_t length;
+    char finishReason[32];
+};
+
+// Everything askai needs from a generateContent response or stream chunk.
+// Token counts are -1 when the response did not include them.
+struct GeminiResponse {
+    struct GeminiCandidate candidates[MAX_SCANNED_CANDIDATES];
+    int candidateCount;
+    long promptTokens;
+    long candidatesTokens;
+    long totalTokens;
+    long errorCode;      // error.code of an error body, 0 otherwise
+    char *errorMessage;  // error.message of an error body, NULL otherwise
+};
+
+// function to extract the interesting fields of a response by walking the raw
+// JSON, skipping every other subtree without building a tree or allocating.
+// Only the target strings are unescaped. Returns 0 if the JSON is malformed,
+// in which case whatever was found before the error is still filled in.
+int scanGeminiResponse(const char *json, size_t length,
+                       struct GeminiResponse *response);
+
+// function to release the strings held by a scanned response
+void freeGeminiResponse(struct GeminiResponse *response);
+#endif
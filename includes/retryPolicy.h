@@ -0,0 +1,50 @@
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+#include <curl/curl.h>
+
+// Longest Retry-After askai is willing to wait for, anything longer fails the
+// request right away
+#define MAX_RETRY_AFTER_S 60
+// How often a wait before a retry checks whether it was cancelled
+#define RETRY_POLL_MS 20
+// Latencies kept to estimate the tail used to trigger hedged requests
+#define LATENCY_SAMPLES 64
+// Hedging starts once this many latencies were seen
+#define HEDGE_MIN_SAMPLES 5
+// Threshold used until enough latencies were seen
+#define HEDGE_DEFAULT_MS 3000
+
+// How a request ended, every kind of failure has its own retry policy
+enum FailureClass {
+    FAILURE_NONE,        // an answer came back
+    FAILURE_FATAL,       // retrying cannot help: bad request, key, cancel
+    FAILURE_NETWORK,     // DNS, connect, TLS or a dropped connection
+    FAILURE_RATE_LIMIT,  // HTTP 429
+    FAILURE_SERVER       // HTTP 5xx and 408
+};
+
+// function to classify the result of a transfer and its HTTP status
+enum FailureClass classifyFailure(CURLcode result, long httpStatus);
+
+// function to name a failure class for messages
+const char *failureName(enum FailureClass failure);
+
+// function to get the wait before retry number `retry` (0 for the first
+// retry): exponential backoff with jitter, or the server's Retry-After when it
+// gave one. Returns -1 when the policy of the class gives up.
+long retryDelayMs(enum FailureClass failure, int retry, long retryAfterS);
+
+// Ring of the most recent latencies of a session
+struct LatencyTracker {
+    double samples[LATENCY_SAMPLES];
+    int count;  // samples stored, at most LATENCY_SAMPLES
+    int next;   // slot the next sample goes to
+};
+
+// function to add one latency in milliseconds
+void recordLatency(struct LatencyTracker *tracker, double ms);
+
+// function to get a percentile (0-100) of the stored latencies, returns 0
+// when fewer than HEDGE_MIN_SAMPLES were seen
+double latencyPercentile(const struct LatencyTracker *tracker, double percent);
+#endif
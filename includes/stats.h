@@ -0,0 +1,46 @@
+#ifndef STATS_H
+#define STATS_H
+#include <curl/curl.h>
+#include <stdio.h>
+
+// Where the time of one turn went, in milliseconds, plus the bytes moved.
+// The network phases come from libcurl's own timers; a phase that did not
+// happen (e.g. DNS and TLS on a reused connection) reads 0.
+struct TurnStats {
+    double prepareMs;   // building the request body
+    double dnsMs;       // name resolution
+    double connectMs;   // TCP connect
+    double tlsMs;       // TLS handshake
+    double ttfbMs;      // from the start of the request to the first byte
+    double transferMs;  // whole transfer, start to last byte
+    double parseMs;     // extracting text from the response
+    double displayMs;   // rendering the answer
+    long requestBytes;
+    long responseBytes;
+    long httpStatus;
+    // Billed tokens as reported by the answer, -1 if it did not say
+    long promptTokens;
+    long candidatesTokens;
+    long totalTokens;
+    int cacheHit;  // answered from the response cache, no request was sent
+    int retries;   // attempts made after the first one failed
+    int hedged;    // a second copy of the request was sent
+};
+
+// function to read a monotonic clock in milliseconds, for timing sections
+double monotonicMs();
+
+// function to reset all counters of a turn
+void initTurnStats(struct TurnStats *stats);
+
+// function to copy the per-phase timers and byte counts of the last transfer
+// done on the handle into the stats
+void collectTransferStats(struct TurnStats *stats, CURL *curl);
+
+// function to print a one line breakdown of the turn
+void printTurnStats(const struct TurnStats *stats, FILE *out);
+
+// function to append the turn as one JSON line to a metrics file, returns 0
+// if the file could not be written
+int appendTurnStats(const struct TurnStats *stats, const char *path);
+#endif
@@ -0,0 +1,42 @@
+#ifndef STREAMHANDLING_H
+#define STREAMHANDLING_H
+#include <stddef.h>
+
+#include "byteRing.h"
+#include "jsonHandling.h"
+#include "myio.h"
+#include "stringBuffer.h"
+
+// State carried across libcurl write callbacks while consuming the
+// server-sent events stream returned by :streamGenerateContent?alt=sse
+struct StreamState {
+    struct StringBuffer pending;  // bytes of a line not terminated yet
+    struct StringBuffer event;    // "data:" lines of the current event
+    struct StringBuffer text;     // full answer text received so far
+    // Lines that are not "data:" fields. An error status comes with a plain
+    // JSON body instead of events, which ends up here.
+    struct StringBuffer other;
+    struct AnswerInfo info;       // finish reason reported by the events
+    struct Renderer *renderer;    // where text fragments are shown
+    struct ByteRing *ring;        // or where they are queued for another thread
+    double parseMs;               // time spent extracting fragments
+    double renderMs;              // time spent rendering fragments
+};
+
+// function to prepare an empty stream state before a request, fragments will
+// be shown through the given renderer, or pushed into ring when it is not
+// NULL so that a different thread can render them
+void initStreamState(struct StreamState *state, struct Renderer *renderer,
+                     struct ByteRing *ring);
+
+// libcurl write callback that splits the body into SSE events and renders the
+// text of every event as soon as it arrives
+size_t StreamCallback(void *contents, size_t size, size_t nmemb, void *userp);
+
+// function to flush a trailing event that was not followed by a blank line,
+// returns the accumulated answer text (owned by the state) or NULL if empty
+char *finishStream(struct StreamState *state);
+
+// function to release all memory held by the stream state
+void freeStreamState(struct StreamState *state);
+#endif
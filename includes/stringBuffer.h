@@ -0,0 +1,37 @@
+#ifndef STRINGBUFFER_H
+#define STRINGBUFFER_H
+#include <stddef.h>
+
+// Growable byte buffer that remembers its length and capacity, so appending
+// never rescans the existing contents. The data is always null terminated
+// once something has been appended.
+struct StringBuffer {
+    char *data;
+    size_t length;
+    size_t capacity;
+};
+
+// function to prepare an empty buffer, no memory is allocated until the first
+// append
+void initStringBuffer(struct StringBuffer *buf);
+
+// function to make room for at least extra more bytes, growing the capacity
+// geometrically, returns 0 when out of memory
+int reserveBuffer(struct StringBuffer *buf, size_t extra);
+
+// function to append len raw bytes in place, returns 0 when out of memory
+int appendToBuffer(struct StringBuffer *buf, const char *bytes, size_t len);
+
+// function to append a null terminated string, returns 0 when out of memory
+int appendStringToBuffer(struct StringBuffer *buf, const char *str);
+
+// function to empty the buffer while keeping its memory for reuse
+void clearBuffer(struct StringBuffer *buf);
+
+// function to hand the contents over to the caller, who must free them, and
+// leave the buffer empty
+char *detachBuffer(struct StringBuffer *buf);
+
+// function to release the memory of the buffer
+void freeStringBuffer(struct StringBuffer *buf);
+#endif
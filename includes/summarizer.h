@@ -0,0 +1,45 @@
+#ifndef SUMMARIZER_H
+#define SUMMARIZER_H
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "requestContext.h"
+#include "stringBuffer.h"
+
+// A summary that takes longer than this is abandoned, its turns are kept for
+// the next attempt
+#define SUMMARY_TIMEOUT_S 60L
+
+// Background worker that folds compacted turns into a running summary with a
+// separate generateContent request, so the chat never waits for it
+struct Summarizer {
+    pthread_t thread;
+    int running;       // a worker was started and has not been joined yet
+    atomic_int done;   // set by the worker once result is ready
+    const struct ApiConfig *config;  // must outlive the summarizer
+    struct RequestContext ctx;  // handle of the worker, set up by startSummary
+    char *prompt;      // request text handed to the worker
+    char *turns;       // dropped turns being summarized, kept in case it fails
+    char *result;      // summary produced by the worker, NULL on failure
+    size_t maxWords;   // length limit asked from the model
+};
+
+// function to prepare an idle summarizer that will send its requests to the
+// configured endpoint
+void initSummarizer(struct Summarizer *summarizer,
+                    const struct ApiConfig *config, size_t maxWords);
+
+// function to start summarizing the previous summary (may be NULL) together
+// with the dropped turns, returns 0 if a summary is already in progress
+int startSummary(struct Summarizer *summarizer, const char *previousSummary,
+                 const char *droppedTurns);
+
+// function to collect a finished summary without blocking, returns NULL if
+// nothing is ready. The caller owns the returned string. If the summary
+// failed, its turns are put back in front of dropped to be summarized again.
+char *takeSummary(struct Summarizer *summarizer, struct StringBuffer *dropped);
+
+// function to cancel any running worker, wait for it and release the
+// summarizer
+void stopSummarizer(struct Summarizer *summarizer);
+#endif
@@ -0,0 +1,88 @@
+// Micro-benchmark for history appends. Build from the repository root with:
+// gcc -O2 -Iincludes snippets/history_append_bench.c src/cJSON.c src/history.c src/requestWriter.c src/stringBuffer.c -o history_append_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "history.h"
+#include "stringBuffer.h"
+
+#define TURNS 10000
+#define REPORT_EVERY 1000
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// The flat-string append that askai.c used to have, kept for comparison
+char *legacyAppendToHistory(char *history, char *role, char *contents) {
+    int historyLen = history ? strlen(history) : 0;
+    int newLen = historyLen + strlen(role) + strlen(contents) + 3;
+
+    char *newHistory = realloc(history, newLen);
+    if (!newHistory)
+        return history;
+
+    if (historyLen == 0) {
+        newHistory[0] = '\0';
+    }
+
+    strcat(newHistory, "\n");
+    strcat(newHistory, role);
+    strcat(newHistory, ":");
+    strcat(newHistory, contents);
+    return newHistory;
+}
+
+int main() {
+    // A typical short exchange, alternated between both roles
+    char text[200];
+    memset(text, 'a', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+
+    printf("%8s %14s %14s %14s\n", "turns", "legacy(ms)", "buffer(ms)",
+           "turns(ms)");
+
+    char *legacy = NULL;
+    struct StringBuffer transcript;
+    initStringBuffer(&transcript);
+    struct ChatHistory history;
+    initHistory(&history);
+
+    double legacyTime = 0, bufferTime = 0, turnTime = 0;
+    for (int i = 1; i <= TURNS; i++) {
+        char *role = (i % 2) ? "user" : "model";
+
+        double start = now_ms();
+        legacy = legacyAppendToHistory(legacy, role, text);
+        legacyTime += now_ms() - start;
+
+        start = now_ms();
+        appendToBuffer(&transcript, "\n", 1);
+        appendStringToBuffer(&transcript, role);
+        appendToBuffer(&transcript, ":", 1);
+        appendStringToBuffer(&transcript, text);
+        bufferTime += now_ms() - start;
+
+        start = now_ms();
+        addTurn(&history, role, text);
+        turnTime += now_ms() - start;
+
+        // Cumulative times should grow linearly for the buffer and the turn
+        // list, and quadratically for the legacy version
+        if (i % REPORT_EVERY == 0)
+            printf("%8d %14.2f %14.2f %14.2f\n", i, legacyTime, bufferTime,
+                   turnTime);
+    }
+
+    if (strcmp(legacy, transcript.data) != 0)
+        printf("mismatch between legacy and buffer transcripts!\n");
+
+    free(legacy);
+    freeStringBuffer(&transcript);
+    freeHistory(&history);
+    return 0;
+}
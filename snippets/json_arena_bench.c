@@ -0,0 +1,180 @@
+// Benchmark of cJSON work done with malloc against a JsonArena, on generated
+// responses or on saved response bodies given as arguments. Build with:
+// gcc -O2 -Iincludes snippets/json_arena_bench.c src/jsonArena.c src/stringBuffer.c src/cJSON.c -o json_arena_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+#include "jsonArena.h"
+#include "stringBuffer.h"
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Allocations made through cJSON while the counting hooks are installed
+static size_t mallocCalls = 0;
+static size_t freeCalls = 0;
+
+static void *countingMalloc(size_t size) {
+    mallocCalls++;
+    return malloc(size);
+}
+
+static void countingFree(void *p) {
+    freeCalls++;
+    free(p);
+}
+
+// Builds a response with textSize bytes of answer text, one citation per
+// 512 bytes of text and a full set of safety ratings
+static char *makeResponse(size_t textSize) {
+    struct StringBuffer out;
+    initStringBuffer(&out);
+    appendStringToBuffer(&out, "{\"candidates\":[{\"content\":{\"parts\":[{"
+                               "\"text\":\"");
+    while (out.length < textSize)
+        appendStringToBuffer(&out, "some answer text\\nwith \\\"escapes\\\" ");
+    appendStringToBuffer(&out, "\"}],\"role\":\"model\"},\"finishReason\":"
+                               "\"STOP\",\"safetyRatings\":[");
+    for (int c = 0; c < 4; c++) {
+        char rating[128];
+        snprintf(rating, sizeof(rating),
+                 "%s{\"category\":\"HARM_CATEGORY_%d\",\"probability\":"
+                 "\"NEGLIGIBLE\",\"blocked\":false}",
+                 c ? "," : "", c);
+        appendStringToBuffer(&out, rating);
+    }
+    appendStringToBuffer(&out, "],\"citationMetadata\":{\"citationSources\":[");
+    size_t sources = 1 + textSize / 512;
+    for (size_t c = 0; c < sources; c++) {
+        char source[160];
+        snprintf(source, sizeof(source),
+                 "%s{\"startIndex\":%zu,\"endIndex\":%zu,\"uri\":"
+                 "\"https://example.com/source/%zu\",\"license\":\"\"}",
+                 c ? "," : "", c * 100, c * 100 + 80, c);
+        appendStringToBuffer(&out, source);
+    }
+    appendStringToBuffer(&out, "]}}],\"usageMetadata\":{\"promptTokenCount\":"
+                               "12,\"candidatesTokenCount\":3456,"
+                               "\"totalTokenCount\":3468},\"modelVersion\":"
+                               "\"gemini-2.5-flash-lite\"}");
+    return detachBuffer(&out);
+}
+
+static char *readFile(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    struct StringBuffer out;
+    initStringBuffer(&out);
+    char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), file)) > 0)
+        appendToBuffer(&out, block, n);
+    fclose(file);
+    return detachBuffer(&out);
+}
+
+// One request's worth of JSON work, returns the printed length so the
+// compiler cannot drop it. In the arena the tree is not deleted, the reset
+// drops it with everything else.
+static size_t roundTrip(const char *json, int deleteTree) {
+    cJSON *root = cJSON_Parse(json);
+    char *printed = cJSON_PrintUnformatted(root);
+    size_t length = printed ? strlen(printed) : 0;
+    cJSON_free(printed);
+    if (deleteTree)
+        cJSON_Delete(root);
+    return length;
+}
+
+static int iterationsFor(const char *json) {
+    return (int)(100000000 / (strlen(json) + 1000)) + 1;
+}
+
+// Heap calls and time of one round trip with the default malloc hooks
+static void benchMalloc(const char *json, size_t *calls, double *ms) {
+    cJSON_Hooks counting = {countingMalloc, countingFree};
+    cJSON_InitHooks(&counting);
+    mallocCalls = freeCalls = 0;
+    roundTrip(json, 1);
+    *calls = mallocCalls + freeCalls;
+    cJSON_InitHooks(NULL);
+
+    int iterations = iterationsFor(json);
+    size_t check = 0;
+    double start = now_ms();
+    for (int i = 0; i < iterations; i++)
+        check += roundTrip(json, 1);
+    *ms = check ? (now_ms() - start) / iterations : 0;
+}
+
+// Time of one round trip in an arena that is reset after every request, and
+// the allocations it served per request
+static void benchArena(const char *json, double *served, double *ms) {
+    struct JsonArena arena;
+    initJsonArena(&arena);
+    int iterations = iterationsFor(json);
+    size_t check = 0;
+    double start = now_ms();
+    for (int i = 0; i < iterations; i++) {
+        beginJsonArena(&arena);
+        check += roundTrip(json, 0);
+        endJsonArena();
+        resetJsonArena(&arena);
+    }
+    *ms = check ? (now_ms() - start) / iterations : 0;
+    *served = (double)arena.allocations / iterations;
+    freeJsonArena(&arena);
+}
+
+int main(int argc, char *argv[]) {
+    // Saved responses from the command line, or generated ones
+    int count = argc > 1 ? argc - 1 : 4;
+    char **inputs = calloc(count, sizeof(char *));
+    char **labels = calloc(count, sizeof(char *));
+    size_t sizes[] = {1024, 16 * 1024, 128 * 1024, 1024 * 1024};
+    for (int i = 0; i < count; i++) {
+        if (argc > 1) {
+            inputs[i] = readFile(argv[i + 1]);
+            labels[i] = strdup(argv[i + 1]);
+            if (!inputs[i])
+                fprintf(stderr, "cannot read %s\n", argv[i + 1]);
+        } else {
+            inputs[i] = makeResponse(sizes[i]);
+            labels[i] = malloc(32);
+            snprintf(labels[i], 32, "generated %zu KB", sizes[i] / 1024);
+        }
+    }
+
+    size_t *calls = calloc(count, sizeof(size_t));
+    double *heapMs = calloc(count, sizeof(double));
+    for (int i = 0; i < count; i++) {
+        if (inputs[i])
+            benchMalloc(inputs[i], &calls[i], &heapMs[i]);
+    }
+
+    printf("%-22s %9s %10s %12s %11s %11s %8s\n", "response", "bytes",
+           "heap calls", "arena allocs", "malloc(ms)", "arena(ms)", "speedup");
+    for (int i = 0; i < count; i++) {
+        if (!inputs[i])
+            continue;
+        double served, arenaMs;
+        benchArena(inputs[i], &served, &arenaMs);
+        printf("%-22s %9zu %10zu %12.0f %11.4f %11.4f %7.2fx\n", labels[i],
+               strlen(inputs[i]), calls[i], served, heapMs[i], arenaMs,
+               arenaMs > 0 ? heapMs[i] / arenaMs : 0);
+        free(inputs[i]);
+        free(labels[i]);
+    }
+    free(inputs);
+    free(labels);
+    free(calls);
+    free(heapMs);
+    return 0;
+}
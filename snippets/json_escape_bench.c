@@ -0,0 +1,110 @@
+// Escaping throughput of cJSON printing and of the request writer, which
+// uses cJSON's escaper without a tree. Add -DCJSON_NO_SIMD for the scalar
+// fallback. Build with:
+// gcc -O2 -Iincludes snippets/json_escape_bench.c src/cJSON.c src/requestWriter.c src/stringBuffer.c -o json_escape_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+#include "requestWriter.h"
+#include "stringBuffer.h"
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Builds `size` bytes of text out of the given words
+static char *makeText(const char *const *words, int count, size_t size) {
+    char *text = malloc(size + 64);
+    size_t length = 0;
+    for (int i = 0; length < size; i = (i + 1) % count) {
+        size_t w = strlen(words[i]);
+        memcpy(text + length, words[i], w);
+        length += w;
+    }
+    text[length] = '\0';
+    return text;
+}
+
+// Best of a few rounds, to keep other load on the machine out of it
+static double bestMs(int useCJSON, cJSON *root, const char *text,
+                     size_t length) {
+    int iterations = (int)(100000000 / (length + 1000)) + 1;
+    double best = 0;
+    for (int round = 0; round < 5; round++) {
+        double start = now_ms();
+        for (int i = 0; i < iterations; i++) {
+            if (useCJSON) {
+                free(cJSON_PrintUnformatted(root));
+            } else {
+                struct StringBuffer buf;
+                initStringBuffer(&buf);
+                appendJsonString(&buf, text, length);
+                freeStringBuffer(&buf);
+            }
+        }
+        double ms = (now_ms() - start) / iterations;
+        if (round == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+static void bench(const char *label, const char *text) {
+    size_t length = strlen(text);
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "text", text);
+
+    // Both escapers follow the same rules, so they must agree
+    char *printed = cJSON_PrintUnformatted(root);
+    struct StringBuffer buf;
+    initStringBuffer(&buf);
+    appendJsonString(&buf, text, length);
+    if (strncmp(printed + strlen("{\"text\":"), buf.data, buf.length) != 0)
+        printf("%s: escapers differ!\n", label);
+    freeStringBuffer(&buf);
+    free(printed);
+
+    double mb = length / (1024.0 * 1024.0);
+    double cjson = bestMs(1, root, text, length);
+    double writer = bestMs(0, root, text, length);
+    printf("%-28s %9zu %12.1f %12.1f\n", label, length, mb / (cjson / 1000),
+           mb / (writer / 1000));
+    cJSON_Delete(root);
+}
+
+int main() {
+    // Plain prose, prose with the occasional newline and quote, and text
+    // dense with escapes such as source code pasted into a prompt
+    static const char *prose[] = {"The quick brown fox jumps over the lazy ",
+                                  "dog, and then asks a long question. "};
+    static const char *mixed[] = {"Some text\n", "with \"quotes\" and ",
+                                  "a path C:\\tmp in a longer sentence. "};
+    static const char *dense[] = {"\t{", "\"a\"", ":\n", "\x01"};
+
+    printf("%-28s %9s %12s %12s\n", "string", "bytes", "cJSON MB/s",
+           "writer MB/s");
+    size_t sizes[] = {1024, 100 * 1024, 1024 * 1024};
+    for (int i = 0; i < 3; i++) {
+        struct {
+            const char *name;
+            const char *const *words;
+            int count;
+        } kinds[] = {{"prose", prose, 2},
+                     {"mixed", mixed, 3},
+                     {"escape dense", dense, 4}};
+        for (int k = 0; k < 3; k++) {
+            char *text = makeText(kinds[k].words, kinds[k].count, sizes[i]);
+            char label[48];
+            snprintf(label, sizeof(label), "%s %zu KB", kinds[k].name,
+                     sizes[i] / 1024);
+            bench(label, text);
+            free(text);
+        }
+    }
+    return 0;
+}
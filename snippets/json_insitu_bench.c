@@ -0,0 +1,98 @@
+// Parse time of cJSON_ParseWithLength against cJSON_ParseInSitu, including
+// the copy that restores the input. Build from the repository root with:
+// gcc -O2 -Iincludes snippets/json_insitu_bench.c src/cJSON.c -o json_insitu_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// An array of `count` small objects with a few short strings each, like a
+// list of messages or batch results, plus one long escaped text per object
+// when textSize is not 0
+static char *makeDocument(int count, size_t textSize) {
+    size_t capacity = (size_t)count * (textSize + 256) + 16;
+    char *json = malloc(capacity);
+    size_t length = 0;
+    json[length++] = '[';
+    for (int i = 0; i < count; i++) {
+        length += sprintf(json + length,
+                          "%s{\"id\":\"msg-%d\",\"role\":\"%s\",\"status\":"
+                          "\"done\",\"lang\":\"en\",\"text\":\"",
+                          i ? "," : "", i, i % 2 ? "model" : "user");
+        for (size_t t = 0; t < textSize; t += 32)
+            length += sprintf(json + length, "plain words and a \\\"quote\\\"\\n");
+        length += sprintf(json + length, "\"}");
+    }
+    json[length++] = ']';
+    json[length] = '\0';
+    return json;
+}
+
+static void bench(const char *label, const char *json) {
+    size_t length = strlen(json);
+    char *work = malloc(length + 1);
+    int iterations = (int)(100000000 / (length + 1000)) + 1;
+
+    // Both parses must give the same document
+    memcpy(work, json, length + 1);
+    cJSON *copied = cJSON_ParseWithLength(json, length);
+    cJSON *inSitu = cJSON_ParseInSitu(work, length);
+    char *a = cJSON_PrintUnformatted(copied);
+    char *b = cJSON_PrintUnformatted(inSitu);
+    if (!a || !b || strcmp(a, b) != 0)
+        printf("%s: results differ!\n", label);
+    free(a);
+    free(b);
+    cJSON_Delete(copied);
+    cJSON_Delete(inSitu);
+
+    // Best of a few rounds, to keep other load on the machine out of it
+    double copyMs = 0, inSituMs = 0;
+    for (int round = 0; round < 5; round++) {
+        double start = now_ms();
+        for (int i = 0; i < iterations; i++)
+            cJSON_Delete(cJSON_ParseWithLength(json, length));
+        double ms = (now_ms() - start) / iterations;
+        if (round == 0 || ms < copyMs)
+            copyMs = ms;
+
+        start = now_ms();
+        for (int i = 0; i < iterations; i++) {
+            memcpy(work, json, length);
+            cJSON_Delete(cJSON_ParseInSitu(work, length));
+        }
+        ms = (now_ms() - start) / iterations;
+        if (round == 0 || ms < inSituMs)
+            inSituMs = ms;
+    }
+    printf("%-28s %10zu %10.4f %10.4f %8.2fx\n", label, length, copyMs,
+           inSituMs, copyMs / inSituMs);
+    free(work);
+}
+
+int main() {
+    printf("%-28s %10s %10s %10s %9s\n", "document", "bytes", "copy(ms)",
+           "insitu(ms)", "speedup");
+    struct {
+        const char *label;
+        int count;
+        size_t textSize;
+    } documents[] = {{"100 short objects", 100, 0},
+                     {"10000 short objects", 10000, 0},
+                     {"100 objects, 1 KB text", 100, 1024},
+                     {"10 objects, 100 KB text", 10, 100 * 1024}};
+    for (int i = 0; i < 4; i++) {
+        char *json = makeDocument(documents[i].count, documents[i].textSize);
+        bench(documents[i].label, json);
+        free(json);
+    }
+    return 0;
+}
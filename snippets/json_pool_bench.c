@@ -0,0 +1,151 @@
+// Benchmark of parse + delete against parsing into a reset cJSON_Pool, on
+// generated responses or on saved responses given as arguments. Build with:
+// gcc -O2 -Iincludes snippets/json_pool_bench.c src/stringBuffer.c src/cJSON.c -o json_pool_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+#include "stringBuffer.h"
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Builds a response with textSize bytes of answer text, one citation per
+// 256 bytes of text and a full set of safety ratings on every candidate
+static char *makeResponse(size_t textSize, int candidates) {
+    struct StringBuffer out;
+    initStringBuffer(&out);
+    appendStringToBuffer(&out, "{\"candidates\":[");
+    for (int k = 0; k < candidates; k++) {
+        appendStringToBuffer(&out, k ? ",{" : "{");
+        appendStringToBuffer(&out, "\"content\":{\"parts\":[{\"text\":\"");
+        size_t start = out.length;
+        while (out.length - start < textSize)
+            appendStringToBuffer(&out, "answer text with \\\"escapes\\\"\\n");
+        appendStringToBuffer(&out, "\"}],\"role\":\"model\"},\"finishReason\":"
+                                   "\"STOP\",\"index\":");
+        char number[16];
+        snprintf(number, sizeof(number), "%d", k);
+        appendStringToBuffer(&out, number);
+        appendStringToBuffer(&out, ",\"safetyRatings\":[");
+        for (int c = 0; c < 4; c++) {
+            char rating[160];
+            snprintf(rating, sizeof(rating),
+                     "%s{\"category\":\"HARM_CATEGORY_%d\",\"probability\":"
+                     "\"NEGLIGIBLE\",\"probabilityScore\":0.0%d,"
+                     "\"blocked\":false}",
+                     c ? "," : "", c, c);
+            appendStringToBuffer(&out, rating);
+        }
+        appendStringToBuffer(&out,
+                             "],\"citationMetadata\":{\"citationSources\":[");
+        size_t sources = 1 + textSize / 256;
+        for (size_t c = 0; c < sources; c++) {
+            char source[160];
+            snprintf(source, sizeof(source),
+                     "%s{\"startIndex\":%zu,\"endIndex\":%zu,\"uri\":"
+                     "\"https://example.com/source/%zu\",\"license\":\"\"}",
+                     c ? "," : "", c * 100, c * 100 + 80, c);
+            appendStringToBuffer(&out, source);
+        }
+        appendStringToBuffer(&out, "]}}");
+    }
+    appendStringToBuffer(&out, "],\"usageMetadata\":{\"promptTokenCount\":12,"
+                               "\"candidatesTokenCount\":3456,"
+                               "\"totalTokenCount\":3468},\"modelVersion\":"
+                               "\"gemini-2.5-flash-lite\"}");
+    return detachBuffer(&out);
+}
+
+static char *readFile(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    struct StringBuffer out;
+    initStringBuffer(&out);
+    char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), file)) > 0)
+        appendToBuffer(&out, block, n);
+    fclose(file);
+    return detachBuffer(&out);
+}
+
+static size_t countNodes(const cJSON *item) {
+    size_t count = 0;
+    for (; item; item = item->next)
+        count += 1 + countNodes(item->child);
+    return count;
+}
+
+static void bench(const char *label, const char *json) {
+    size_t length = strlen(json);
+    int iterations = (int)(200000000 / (length + 1000)) + 1;
+    cJSON_Pool *pool = cJSON_CreatePool();
+
+    // Both parses must build the same tree
+    cJSON *heapTree = cJSON_Parse(json);
+    cJSON *poolTree = cJSON_ParseWithPool(pool, json, length + 1);
+    char *expected = cJSON_PrintUnformatted(heapTree);
+    char *actual = cJSON_PrintUnformatted(poolTree);
+    if (!expected || !actual || strcmp(expected, actual) != 0)
+        printf("%s: trees differ!\n", label);
+    size_t nodes = countNodes(heapTree);
+    free(expected);
+    free(actual);
+    cJSON_Delete(heapTree);
+    cJSON_ResetPool(pool);
+
+    double start = now_ms();
+    for (int i = 0; i < iterations; i++)
+        cJSON_Delete(cJSON_Parse(json));
+    double heap = (now_ms() - start) / iterations;
+
+    start = now_ms();
+    for (int i = 0; i < iterations; i++) {
+        cJSON_ParseWithPool(pool, json, length + 1);
+        cJSON_ResetPool(pool);
+    }
+    double pooled = (now_ms() - start) / iterations;
+    cJSON_DeletePool(pool);
+
+    double mb = length / (1024.0 * 1024.0);
+    printf("%-24s %9zu %7zu %10.1f %10.1f %7.2fx\n", label, length, nodes,
+           mb / (heap / 1000), mb / (pooled / 1000), heap / pooled);
+}
+
+int main(int argc, char *argv[]) {
+    printf("%-24s %9s %7s %10s %10s %8s\n", "response", "bytes", "nodes",
+           "heap MB/s", "pool MB/s", "speedup");
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            char *json = readFile(argv[i]);
+            if (!json) {
+                fprintf(stderr, "cannot read %s\n", argv[i]);
+                continue;
+            }
+            bench(argv[i], json);
+            free(json);
+        }
+        return 0;
+    }
+
+    size_t sizes[] = {1024, 16 * 1024, 128 * 1024, 1024 * 1024};
+    for (int i = 0; i < 4; i++) {
+        for (int candidates = 1; candidates <= 4; candidates *= 4) {
+            char *json = makeResponse(sizes[i], candidates);
+            char label[48];
+            snprintf(label, sizeof(label), "%zu KB x %d candidate%s",
+                     sizes[i] / 1024, candidates, candidates > 1 ? "s" : "");
+            bench(label, json);
+            free(json);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Time, allocations and peak memory of cJSON printing for large documents.
+// Build from the repository root with:
+// gcc -O2 -Iincludes snippets/json_print_bench.c src/cJSON.c -o json_print_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Counting hooks: every block carries its size in front, so the live bytes
+// and their peak can be tracked
+static size_t allocations, liveBytes, peakBytes;
+
+static void *countingMalloc(size_t size) {
+    size_t *block = malloc(sizeof(size_t) * 2 + size);
+    if (!block)
+        return NULL;
+    block[0] = size;
+    allocations++;
+    liveBytes += size;
+    if (liveBytes > peakBytes)
+        peakBytes = liveBytes;
+    return block + 2;
+}
+
+static void countingFree(void *pointer) {
+    if (!pointer)
+        return;
+    size_t *block = (size_t *)pointer - 2;
+    liveBytes -= block[0];
+    free(block);
+}
+
+// A chat history like document: an array of turns with a long text each,
+// plus some numbers, totalling about `size` bytes
+static cJSON *makeDocument(size_t size) {
+    static const char *sentence =
+        "The quick brown fox jumps over the lazy dog.\n\"Quoted\" text, "
+        "a tab\tand plain ASCII prose make up most of a model answer. ";
+    cJSON *root = cJSON_CreateObject();
+    cJSON *contents = cJSON_AddArrayToObject(root, "contents");
+    size_t turnSize = 4096, total = 0;
+    char *text = malloc(turnSize + 1);
+    for (size_t i = 0; i < turnSize; i++)
+        text[i] = sentence[i % strlen(sentence)];
+    text[turnSize] = '\0';
+
+    for (int turn = 0; total < size; turn++) {
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddStringToObject(entry, "role", turn % 2 ? "model" : "user");
+        cJSON *parts = cJSON_AddArrayToObject(entry, "parts");
+        cJSON *part = cJSON_CreateObject();
+        cJSON_AddStringToObject(part, "text", text);
+        cJSON_AddItemToArray(parts, part);
+        cJSON_AddNumberToObject(entry, "tokens", 1000 + turn);
+        cJSON_AddNumberToObject(entry, "temperature", 0.7);
+        cJSON_AddItemToArray(contents, entry);
+        total += turnSize + 100;
+    }
+    free(text);
+    return root;
+}
+
+static void bench(const char *label, cJSON *root, int format) {
+    char *printed = format ? cJSON_Print(root) : cJSON_PrintUnformatted(root);
+    size_t length = strlen(printed);
+    cJSON_free(printed);
+
+    allocations = 0;
+    peakBytes = liveBytes;
+    size_t baseBytes = liveBytes;
+    int iterations = (int)(200000000 / (length + 1000)) + 1;
+    double best = 0;
+    for (int round = 0; round < 5; round++) {
+        double start = now_ms();
+        for (int i = 0; i < iterations; i++) {
+            printed = format ? cJSON_Print(root) : cJSON_PrintUnformatted(root);
+            cJSON_free(printed);
+        }
+        double ms = (now_ms() - start) / iterations;
+        if (round == 0 || ms < best)
+            best = ms;
+    }
+    printf("%-24s %10zu %10.3f %12.1f %10.2f\n", label, length, best,
+           (double)allocations / (iterations * 5),
+           (double)(peakBytes - baseBytes) / length);
+}
+
+int main() {
+    cJSON_Hooks hooks = {countingMalloc, countingFree};
+    cJSON_InitHooks(&hooks);
+
+    printf("%-24s %10s %10s %12s %10s\n", "document", "bytes", "ms",
+           "allocations", "peak/size");
+    size_t sizes[] = {16 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+    for (int i = 0; i < 3; i++) {
+        cJSON *root = makeDocument(sizes[i]);
+        char label[48];
+        snprintf(label, sizeof(label), "unformatted %zu KB", sizes[i] / 1024);
+        bench(label, root, 0);
+        snprintf(label, sizeof(label), "formatted %zu KB", sizes[i] / 1024);
+        bench(label, root, 1);
+        cJSON_Delete(root);
+    }
+    return 0;
+}
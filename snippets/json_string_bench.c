@@ -0,0 +1,109 @@
+// Parse throughput of long JSON strings, add -DCJSON_NO_SIMD for the scalar
+// fallback. Build from the repository root with:
+// gcc -O2 -Iincludes snippets/json_string_bench.c src/cJSON.c -o json_string_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Which kernel parse_string runs with in this build on this CPU
+static const char *kernelName() {
+#if defined(CJSON_NO_SIMD) || !defined(__GNUC__) || !defined(__x86_64__)
+    return "scalar";
+#else
+    return __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+#endif
+}
+
+// Builds a JSON document {"text": "..."} whose decoded text is `size` bytes
+// of the given words, and returns the decoded text in *expected
+static char *makeDocument(const char *const *words, const char *const *escaped,
+                          int count, size_t size, char **expected) {
+    char *json = malloc(size * 6 + 32);
+    char *text = malloc(size + 64);
+    size_t jsonLength = 0, textLength = 0;
+    jsonLength += sprintf(json, "{\"text\": \"");
+    for (int i = 0; textLength < size; i = (i + 1) % count) {
+        size_t w = strlen(words[i]), e = strlen(escaped[i]);
+        memcpy(text + textLength, words[i], w);
+        memcpy(json + jsonLength, escaped[i], e);
+        textLength += w;
+        jsonLength += e;
+    }
+    text[textLength] = '\0';
+    strcpy(json + jsonLength, "\"}");
+    *expected = text;
+    return json;
+}
+
+static void bench(const char *label, const char *json, const char *expected) {
+    size_t length = strlen(json);
+    cJSON *root = cJSON_Parse(json);
+    cJSON *text = cJSON_GetObjectItemCaseSensitive(root, "text");
+    if (!cJSON_IsString(text) || strcmp(text->valuestring, expected) != 0)
+        printf("%s: wrong result!\n", label);
+    cJSON_Delete(root);
+
+    // Best of a few rounds, to keep other load on the machine out of it
+    int iterations = (int)(100000000 / (length + 1000)) + 1;
+    double ms = 0;
+    for (int round = 0; round < 5; round++) {
+        double start = now_ms();
+        for (int i = 0; i < iterations; i++)
+            cJSON_Delete(cJSON_Parse(json));
+        double roundMs = (now_ms() - start) / iterations;
+        if (round == 0 || roundMs < ms)
+            ms = roundMs;
+    }
+    printf("%-28s %9zu %10.1f\n", label, length,
+           length / (1024.0 * 1024.0) / (ms / 1000));
+}
+
+int main() {
+    // Plain prose, prose with the occasional newline and quote, and text
+    // dense with escapes such as code or non-ASCII written as \u escapes
+    static const char *prose[] = {"The quick brown fox jumps over the lazy ",
+                                  "dog, and then writes a long answer. "};
+    static const char *mixed[] = {"Some text\n", "with \"quotes\" and ",
+                                  "a path C:\\tmp in a longer sentence. "};
+    static const char *mixedEscaped[] = {
+        "Some text\\n", "with \\\"quotes\\\" and ",
+        "a path C:\\\\tmp in a longer sentence. "};
+    static const char *dense[] = {"\t{", "\"a\"", ":\n", "caf\xc3\xa9"};
+    static const char *denseEscaped[] = {"\\t{", "\\\"a\\\"", ":\\n",
+                                         "caf\\u00e9"};
+
+    printf("kernel: %s\n", kernelName());
+    printf("%-28s %9s %10s\n", "string", "bytes", "MB/s");
+    size_t sizes[] = {1024, 100 * 1024, 1024 * 1024};
+    for (int i = 0; i < 3; i++) {
+        struct {
+            const char *name;
+            const char *const *words;
+            const char *const *escaped;
+            int count;
+        } kinds[] = {{"prose", prose, prose, 2},
+                     {"mixed", mixed, mixedEscaped, 3},
+                     {"escape dense", dense, denseEscaped, 4}};
+        for (int k = 0; k < 3; k++) {
+            char *expected;
+            char *json = makeDocument(kinds[k].words, kinds[k].escaped,
+                                      kinds[k].count, sizes[i], &expected);
+            char label[48];
+            snprintf(label, sizeof(label), "%s %zu KB", kinds[k].name,
+                     sizes[i] / 1024);
+            bench(label, json, expected);
+            free(json);
+            free(expected);
+        }
+    }
+    return 0;
+}
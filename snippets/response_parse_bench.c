@@ -0,0 +1,167 @@
+// Benchmark of the response scanner against a cJSON tree parse, on generated
+// responses or on saved response bodies given as arguments. Build with:
+// gcc -O2 -Iincludes snippets/response_parse_bench.c src/responseScanner.c src/stringBuffer.c src/cJSON.c -o response_parse_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+#include "responseScanner.h"
+#include "stringBuffer.h"
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// The cJSON based extraction askai used before the scanner
+static char *treeParse(const char *response_json) {
+    cJSON *root = cJSON_Parse(response_json);
+    if (!root)
+        return NULL;
+    cJSON *candidates = cJSON_GetObjectItemCaseSensitive(root, "candidates");
+    cJSON *candidate = cJSON_GetArrayItem(candidates, 0);
+    cJSON *content = cJSON_GetObjectItemCaseSensitive(candidate, "content");
+    cJSON *parts = cJSON_GetObjectItemCaseSensitive(content, "parts");
+    cJSON *part = cJSON_GetArrayItem(parts, 0);
+    cJSON *text_obj = cJSON_GetObjectItemCaseSensitive(part, "text");
+    char *text = text_obj ? strdup(text_obj->valuestring) : NULL;
+    cJSON_Delete(root);
+    return text;
+}
+
+static char *scanParse(const char *response_json, size_t length) {
+    struct GeminiResponse response;
+    scanGeminiResponse(response_json, length, &response);
+    char *text = NULL;
+    if (response.candidateCount > 0) {
+        text = response.candidates[0].text;
+        response.candidates[0].text = NULL;
+    }
+    freeGeminiResponse(&response);
+    return text;
+}
+
+// Builds a response with textSize bytes of escaped answer text and the usual
+// metadata around it
+static char *makeResponse(size_t textSize) {
+    static const char *words[] = {
+        "the ", "model ", "answer\\n", "with ", "\\\"quotes\\\" ",
+        "caf\\u00e9 ", "emoji \\ud83d\\ude00 ", "    code();\\n", "tabs\\t",
+        "and ", "plain ", "ASCII ", "sentences. "};
+    struct StringBuffer out;
+    initStringBuffer(&out);
+
+    appendStringToBuffer(
+        &out, "{\n  \"candidates\": [\n    {\n      \"content\": {\n"
+              "        \"parts\": [\n          {\n            \"text\": \"");
+    size_t i = 0;
+    while (out.length < textSize)
+        appendStringToBuffer(&out, words[i++ % 13]);
+    appendStringToBuffer(&out, "\"\n          }\n        ],\n"
+                               "        \"role\": \"model\"\n      },\n"
+                               "      \"finishReason\": \"STOP\",\n"
+                               "      \"safetyRatings\": [\n");
+    static const char *categories[] = {
+        "HARM_CATEGORY_SEXUALLY_EXPLICIT", "HARM_CATEGORY_HATE_SPEECH",
+        "HARM_CATEGORY_HARASSMENT", "HARM_CATEGORY_DANGEROUS_CONTENT"};
+    for (int c = 0; c < 4; c++) {
+        char rating[160];
+        snprintf(rating, sizeof(rating),
+                 "        {\"category\": \"%s\", \"probability\": "
+                 "\"NEGLIGIBLE\"}%s\n",
+                 categories[c], c < 3 ? "," : "");
+        appendStringToBuffer(&out, rating);
+    }
+    appendStringToBuffer(&out, "      ],\n      \"citationMetadata\": {\n"
+                               "        \"citationSources\": [\n");
+    // Long answers cite more sources
+    size_t sources = 1 + textSize / 4096;
+    for (size_t c = 0; c < sources; c++) {
+        char source[200];
+        snprintf(source, sizeof(source),
+                 "          {\"startIndex\": %zu, \"endIndex\": %zu, \"uri\": "
+                 "\"https://example.com/source/%zu\", \"license\": \"\"}%s\n",
+                 c * 100, c * 100 + 80, c, c + 1 < sources ? "," : "");
+        appendStringToBuffer(&out, source);
+    }
+    appendStringToBuffer(
+        &out, "        ]\n      },\n      \"avgLogprobs\": -0.1234\n    }\n"
+              "  ],\n  \"usageMetadata\": {\n    \"promptTokenCount\": 12,\n"
+              "    \"candidatesTokenCount\": 3456,\n"
+              "    \"totalTokenCount\": 3468,\n"
+              "    \"promptTokensDetails\": [{\"modality\": \"TEXT\", "
+              "\"tokenCount\": 12}]\n  },\n"
+              "  \"modelVersion\": \"gemini-2.5-flash-lite\",\n"
+              "  \"responseId\": \"abcdefghijklmnop\"\n}\n");
+    return detachBuffer(&out);
+}
+
+static char *readFile(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    struct StringBuffer out;
+    initStringBuffer(&out);
+    char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), file)) > 0)
+        appendToBuffer(&out, block, n);
+    fclose(file);
+    return detachBuffer(&out);
+}
+
+static void bench(const char *label, const char *json) {
+    size_t length = strlen(json);
+    int iterations = (int)(200000000 / (length + 1000)) + 1;
+
+    char *expected = treeParse(json);
+    char *actual = scanParse(json, length);
+    if (!expected || !actual || strcmp(expected, actual) != 0)
+        printf("%s: results differ!\n", label);
+    free(expected);
+    free(actual);
+
+    double start = now_ms();
+    for (int i = 0; i < iterations; i++)
+        free(treeParse(json));
+    double tree = (now_ms() - start) / iterations;
+
+    start = now_ms();
+    for (int i = 0; i < iterations; i++)
+        free(scanParse(json, length));
+    double scan = (now_ms() - start) / iterations;
+
+    printf("%-24s %10zu %12.4f %12.4f %8.1fx\n", label, length, tree, scan,
+           tree / scan);
+}
+
+int main(int argc, char *argv[]) {
+    printf("%-24s %10s %12s %12s %9s\n", "response", "bytes", "cJSON(ms)",
+           "scanner(ms)", "speedup");
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            char *json = readFile(argv[i]);
+            if (!json) {
+                fprintf(stderr, "cannot read %s\n", argv[i]);
+                continue;
+            }
+            bench(argv[i], json);
+            free(json);
+        }
+        return 0;
+    }
+
+    size_t sizes[] = {1024, 16 * 1024, 128 * 1024, 1024 * 1024};
+    for (int i = 0; i < 4; i++) {
+        char *json = makeResponse(sizes[i]);
+        char label[32];
+        snprintf(label, sizeof(label), "generated %zu KB", sizes[i] / 1024);
+        bench(label, json);
+        free(json);
+    }
+    return 0;
+}
@@ -5,12 +5,18 @@
 #include <string.h>
 #include <sys/stat.h>   // For mkdir() and chmod()
 #include <sys/types.h>  // For mkdir()
+#include <unistd.h>     // For isatty()
 
 char *getApiKey() {
     char config_dir[1024];
     char config_path[1024];
     const char *home_dir = getenv("HOME");
 
+    // 0. AN API KEY IN THE ENVIRONMENT SKIPS THE CONFIG FILE ENTIRELY
+    const char *env_key = getenv("GEMINI_API_KEY");
+    if (env_key && strlen(env_key) > 0)
+        return strdup(env_key);
+
     // 1. CONSTRUCT THE PATHS with bounds checking
     int dir_len =
         snprintf(config_dir, sizeof(config_dir), "%s/.askai-cli", home_dir);
@@ -46,6 +52,13 @@ char *getApiKey() {
     }
 
     // 3. IF READING FAILED, PROMPT THE USER (FIRST-TIME SETUP)
+    // When stdin is a pipe it holds the question, not the key
+    if (!isatty(STDIN_FILENO)) {
+        fprintf(stderr,
+                "Error: no API key found. Run askai once interactively or set "
+                "GEMINI_API_KEY.\n");
+        return NULL;
+    }
     printf("--- AskAI CLI Setup ---\n");
     printf("Please enter your Gemini API Key: ");
 
@@ -0,0 +1,363 @@
+#include "batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "connectionCache.h"
+#include "jsonArena.h"
+#include "jsonHandling.h"
+#include "requestWriter.h"
+#include "responseScanner.h"
+#include "stringBuffer.h"
+
+// One prompt of the batch and, once it is done, its output line
+struct BatchJob {
+    char *idJson;    // the id of the input line printed back as JSON, or NULL
+    char *postData;  // request body, built when the job is started
+    struct StringBuffer response;
+    char *output;    // finished JSON line, NULL until the job completes
+    int line;        // line of the input the prompt came from, from 1
+    int failed;
+};
+
+// An easy handle that is reused for job after job so its configuration and
+// connection stay warm
+struct BatchSlot {
+    CURL *curl;
+    int job;  // index of the job in flight, -1 when free
+};
+
+static size_t collectBody(void *contents, size_t size, size_t nmemb,
+                          void *userp) {
+    size_t realsize = size * nmemb;
+    if (!appendToBuffer((struct StringBuffer *)userp, contents, realsize))
+        return 0;
+    return realsize;
+}
+
+// helper to read the whole input, either a file or stdin for "-"
+static char *readInput(const char *path) {
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!file)
+        return NULL;
+    struct StringBuffer in;
+    initStringBuffer(&in);
+    char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), file)) > 0)
+        appendToBuffer(&in, block, n);
+    if (file != stdin)
+        fclose(file);
+    if (!in.data)
+        appendToBuffer(&in, "", 0);
+    return detachBuffer(&in);
+}
+
+// Turns one input line into a job, returns 0 if the line is not usable. The
+// line is parsed in place, so the prompt is unescaped inside the input and
+// points into it instead of being copied. The tree only lives until the id
+// is printed, so it is built in the arena and dropped with a reset instead of
+// being freed node by node.
+static int parseJobLine(char *line, size_t length, struct BatchJob *job,
+                        char **prompt, struct JsonArena *arena) {
+    beginJsonArena(arena);
+    cJSON *root = cJSON_ParseInSitu(line, length);
+    // What is kept from the tree is allocated normally
+    endJsonArena();
+    if (!root) {
+        resetJsonArena(arena);
+        return 0;
+    }
+
+    cJSON *text = root;
+    if (cJSON_IsObject(root)) {
+        text = cJSON_GetObjectItemCaseSensitive(root, "prompt");
+        if (!text)
+            text = cJSON_GetObjectItemCaseSensitive(root, "text");
+        cJSON *id = cJSON_GetObjectItemCaseSensitive(root, "id");
+        if (id)
+            job->idJson = cJSON_PrintUnformatted(id);
+    }
+    int ok = cJSON_IsString(text);
+    if (ok)
+        *prompt = text->valuestring;
+    resetJsonArena(arena);
+    return ok;
+}
+
+// helper to start the output line of a job with its input line and id
+static void beginOutput(struct StringBuffer *line, struct BatchJob *job) {
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "{\"line\":%d,\"id\":", job->line);
+    appendStringToBuffer(line, prefix);
+    appendStringToBuffer(line, job->idJson ? job->idJson : "null");
+}
+
+// Builds the output line of a job answered from the cache
+static void finishCachedJob(struct BatchJob *job, char *text) {
+    struct StringBuffer line;
+    initStringBuffer(&line);
+    beginOutput(&line, job);
+    appendStringToBuffer(&line, ",\"text\":");
+    appendJsonString(&line, text, strlen(text));
+    appendStringToBuffer(&line, ",\"cached\":true}\n");
+    free(text);
+
+    job->output = detachBuffer(&line);
+    freeStringBuffer(&job->response);
+    free(job->postData);
+    job->postData = NULL;
+}
+
+// Builds the output line of a finished job from its response, a good answer
+// is also added to the cache
+static void finishJob(struct BatchJob *job, CURLcode res, long status,
+                      struct ResponseCache *cache) {
+    struct StringBuffer line;
+    initStringBuffer(&line);
+    beginOutput(&line, job);
+
+    struct GeminiResponse response;
+    int scanned = res == CURLE_OK &&
+                  scanGeminiResponse(job->response.data, job->response.length,
+                                     &response);
+    if (res != CURLE_OK) {
+        appendStringToBuffer(&line, ",\"error\":");
+        const char *error = curl_easy_strerror(res);
+        appendJsonString(&line, error, strlen(error));
+        job->failed = 1;
+    } else if (!scanned || status != 200 || response.candidateCount == 0 ||
+               !response.candidates[0].text) {
+        char error[64];
+        snprintf(error, sizeof(error), ",\"status\":%ld,\"error\":", status);
+        appendStringToBuffer(&line, error);
+        const char *message = scanned && response.errorMessage
+                                  ? response.errorMessage
+                                  : "no answer in the response";
+        appendJsonString(&line, message, strlen(message));
+        job->failed = 1;
+    } else {
+        struct GeminiCandidate *candidate = &response.candidates[0];
+        appendStringToBuffer(&line, ",\"text\":");
+        appendJsonString(&line, candidate->text, candidate->length);
+        appendStringToBuffer(&line, ",\"finish_reason\":");
+        appendJsonString(&line, candidate->finishReason,
+                         strlen(candidate->finishReason));
+        cacheStore(cache, job->postData, strlen(job->postData),
+                   candidate->text, candidate->length, candidate->finishReason);
+    }
+    appendStringToBuffer(&line, "}\n");
+    if (res == CURLE_OK)
+        freeGeminiResponse(&response);
+
+    job->output = detachBuffer(&line);
+    freeStringBuffer(&job->response);
+    free(job->postData);
+    job->postData = NULL;
+}
+
+// helper to free the jobs and everything they still hold
+static void freeJobs(struct BatchJob *jobs, int count) {
+    for (int i = 0; i < count; i++) {
+        free(jobs[i].idJson);
+        free(jobs[i].postData);
+        free(jobs[i].output);
+        freeStringBuffer(&jobs[i].response);
+    }
+    free(jobs);
+}
+
+int runBatch(const struct ApiConfig *config, const char *path,
+             int concurrency, int ordered, struct ResponseCache *cache) {
+    char *input = readInput(path);
+    if (!input) {
+        fprintf(stderr, "Error: cannot read batch input %s\n", path);
+        return -1;
+    }
+
+    // Split the input into jobs, one per non-empty line
+    struct BatchJob *jobs = NULL;
+    int count = 0, capacity = 0, failed = 0, lineNumber = 0;
+    char **prompts = NULL;
+    struct JsonArena arena;
+    initJsonArena(&arena);
+    for (char *line = input; *line;) {
+        lineNumber++;
+        char *end = strchr(line, '\n');
+        size_t length = end ? (size_t)(end - line) : strlen(line);
+        size_t blank = strspn(line, " \t\r");
+        if (blank < length) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                struct BatchJob *grownJobs =
+                    realloc(jobs, capacity * sizeof(struct BatchJob));
+                if (grownJobs)
+                    jobs = grownJobs;
+                char **grownPrompts =
+                    grownJobs ? realloc(prompts, capacity * sizeof(char *))
+                              : NULL;
+                if (grownPrompts)
+                    prompts = grownPrompts;
+                if (!grownJobs || !grownPrompts) {
+                    fprintf(stderr, "Error: out of memory reading the batch.\n");
+                    freeJsonArena(&arena);
+                    freeJobs(jobs, count);
+                    free(prompts);
+                    free(input);
+                    return -1;
+                }
+            }
+            struct BatchJob *job = &jobs[count];
+            memset(job, 0, sizeof(*job));
+            initStringBuffer(&job->response);
+            job->line = lineNumber;
+            prompts[count] = NULL;
+            if (!parseJobLine(line, length, job, &prompts[count], &arena)) {
+                fprintf(stderr, "Skipping invalid batch line %d\n", lineNumber);
+                free(job->idJson);
+            } else {
+                count++;
+            }
+        }
+        line = end ? end + 1 : line + length;
+    }
+    freeJsonArena(&arena);
+
+    char url[512];
+    if (!buildApiUrl(config, "generateContent", url, sizeof(url))) {
+        fprintf(stderr, "Error: API URL too long.\n");
+        freeJobs(jobs, count);
+        free(prompts);
+        free(input);
+        return -1;
+    }
+    struct curl_slist *headers =
+        curl_slist_append(NULL, "Content-Type: application/json");
+
+    // One multi handle shares its connection pool between all slots, with
+    // HTTP/2 the requests are multiplexed over the same connection
+    CURLM *multi = curl_multi_init();
+    struct BatchSlot *slots =
+        concurrency > 0 ? calloc(concurrency, sizeof(struct BatchSlot)) : NULL;
+    int ready = headers && multi && slots;
+    if (multi) {
+        curl_multi_setopt(multi, CURLMOPT_PIPELINING,
+                          (long)CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                          (long)concurrency);
+        curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                          (long)concurrency);
+    }
+    for (int i = 0; ready && i < concurrency; i++) {
+        slots[i].curl = curl_easy_init();
+        slots[i].job = -1;
+        if (!slots[i].curl) {
+            ready = 0;
+            break;
+        }
+        configureApiHandle(slots[i].curl, headers, url);
+        applyConnectionCache(config->connections, slots[i].curl);
+        curl_easy_setopt(slots[i].curl, CURLOPT_WRITEFUNCTION, collectBody);
+        curl_easy_setopt(slots[i].curl, CURLOPT_PRIVATE, &slots[i]);
+    }
+    if (!ready) {
+        fprintf(stderr, "Error: cannot set up the batch requests.\n");
+        failed = -1;
+    }
+
+    int next = 0, running = 0, emitted = 0;
+    while (ready && (next < count || running > 0)) {
+        // Hand queued prompts to free slots
+        for (int i = 0; i < concurrency && next < count; i++) {
+            if (slots[i].job >= 0)
+                continue;
+            struct BatchJob *job = &jobs[next];
+            job->postData = create_gemini_json_payload(prompts[next]);
+            if (!job->postData) {
+                finishJob(job, CURLE_OUT_OF_MEMORY, 0, cache);
+                next++;
+                failed++;
+                if (!ordered)
+                    fputs(job->output, stdout);
+                i--;
+                continue;
+            }
+
+            curl_easy_setopt(slots[i].curl, CURLOPT_POSTFIELDS, job->postData);
+            curl_easy_setopt(slots[i].curl, CURLOPT_POSTFIELDSIZE,
+                             (long)strlen(job->postData));
+            curl_easy_setopt(slots[i].curl, CURLOPT_WRITEDATA, &job->response);
+            // A cached answer finishes the job without using the slot
+            char *cached =
+                cacheLookup(cache, job->postData, strlen(job->postData));
+            if (cached) {
+                finishCachedJob(job, cached);
+                next++;
+                if (!ordered)
+                    fputs(job->output, stdout);
+                i--;
+                continue;
+            }
+            slots[i].job = next++;
+            curl_multi_add_handle(multi, slots[i].curl);
+            running++;
+        }
+
+        int still_running;
+        curl_multi_perform(multi, &still_running);
+
+        // Collect finished transfers and free their slots
+        CURLMsg *msg;
+        int queued;
+        while ((msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+            struct BatchSlot *slot;
+            long status = 0;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &slot);
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE,
+                              &status);
+            CURLcode res = msg->data.result;
+            if (res == CURLE_OK)
+                rememberConnection(config->connections, msg->easy_handle);
+            curl_multi_remove_handle(multi, msg->easy_handle);
+
+            struct BatchJob *job = &jobs[slot->job];
+            finishJob(job, res, status, cache);
+            failed += job->failed;
+            if (!ordered) {
+                fputs(job->output, stdout);
+                fflush(stdout);
+            }
+            slot->job = -1;
+            running--;
+        }
+
+        // In input order, print every finished job at the front of the queue
+        while (ordered && emitted < count && jobs[emitted].output) {
+            fputs(jobs[emitted].output, stdout);
+            emitted++;
+        }
+        fflush(stdout);
+
+        if (running > 0)
+            curl_multi_poll(multi, NULL, 0, 1000, NULL);
+    }
+
+    // Slots past a failed curl_easy_init were left zeroed by calloc
+    for (int i = 0; slots && i < concurrency; i++) {
+        if (slots[i].curl)
+            curl_easy_cleanup(slots[i].curl);
+    }
+    free(slots);
+    if (multi)
+        curl_multi_cleanup(multi);
+    curl_slist_free_all(headers);
+    freeJobs(jobs, count);
+    // The prompts point into the input
+    free(prompts);
+    free(input);
+    return failed;
+}
@@ -0,0 +1,64 @@
+#include "byteRing.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int initByteRing(struct ByteRing *ring, size_t capacity) {
+    size_t size = 64;
+    while (size < capacity)
+        size *= 2;
+    ring->data = malloc(size);
+    ring->capacity = ring->data ? size : 0;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return ring->data != NULL;
+}
+
+size_t ringWrite(struct ByteRing *ring, const char *data, size_t length) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t space = ring->capacity - (head - tail);
+    if (length > space)
+        length = space;
+    if (length == 0)
+        return 0;
+
+    // The free region may wrap around the end of the buffer
+    size_t offset = head & (ring->capacity - 1);
+    size_t first = ring->capacity - offset;
+    if (first > length)
+        first = length;
+    memcpy(ring->data + offset, data, first);
+    memcpy(ring->data, data + first, length - first);
+
+    // Publish the bytes only after they are in place
+    atomic_store_explicit(&ring->head, head + length, memory_order_release);
+    return length;
+}
+
+size_t ringRead(struct ByteRing *ring, char *out, size_t length) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t available = head - tail;
+    if (length > available)
+        length = available;
+    if (length == 0)
+        return 0;
+
+    size_t offset = tail & (ring->capacity - 1);
+    size_t first = ring->capacity - offset;
+    if (first > length)
+        first = length;
+    memcpy(out, ring->data + offset, first);
+    memcpy(out + first, ring->data, length - first);
+
+    // Hand the space back to the producer once the bytes are copied out
+    atomic_store_explicit(&ring->tail, tail + length, memory_order_release);
+    return length;
+}
+
+void freeByteRing(struct ByteRing *ring) {
+    free(ring->data);
+    ring->data = NULL;
+    ring->capacity = 0;
+}
@@ -275,6 +275,185 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
     }
 }
 
+/* Bytes per slab of a cJSON_Pool, strings longer than this get a block of their own */
+#ifndef CJSON_POOL_SLAB_SIZE
+#define CJSON_POOL_SLAB_SIZE (64 * 1024)
+#endif
+/* Pooled nodes start on a cache line */
+#define CJSON_POOL_ALIGNMENT 64
+
+typedef struct pool_slab
+{
+    struct pool_slab *next;
+    unsigned char *data; /* aligned start of the usable bytes */
+    size_t size;
+    size_t used;
+} pool_slab;
+
+/* One chain of slabs that is filled in order and rewound on reset */
+typedef struct
+{
+    pool_slab *first;
+    pool_slab *current;
+} pool_chain;
+
+struct cJSON_Pool
+{
+    pool_chain nodes;
+    pool_chain strings;
+    pool_slab *large; /* oversized strings, freed on reset */
+};
+
+static pool_slab *create_slab(size_t size, size_t alignment)
+{
+    pool_slab *slab = (pool_slab*)global_hooks.allocate(sizeof(pool_slab) + size + alignment);
+    size_t start = 0;
+    if (slab == NULL)
+    {
+        return NULL;
+    }
+
+    start = (size_t)(((unsigned char*)slab) + sizeof(pool_slab));
+    start = (start + alignment - 1) & ~(alignment - 1);
+    slab->next = NULL;
+    slab->data = (unsigned char*)start;
+    slab->size = size;
+    slab->used = 0;
+
+    return slab;
+}
+
+static void free_slabs(pool_slab *slab)
+{
+    while (slab != NULL)
+    {
+        pool_slab *next = slab->next;
+        global_hooks.deallocate(slab);
+        slab = next;
+    }
+}
+
+/* take size bytes from the chain, moving on to the next slab (or a new one) when the current one is full */
+static void *chain_allocate(pool_chain * const chain, size_t size, size_t alignment)
+{
+    pool_slab *slab = chain->current;
+    pool_slab *last = chain->current;
+    size_t offset = 0;
+
+    while (slab != NULL)
+    {
+        offset = (slab->used + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= slab->size)
+        {
+            slab->used = offset + size;
+            chain->current = slab;
+            return slab->data + offset;
+        }
+        last = slab;
+        slab = slab->next;
+        if (slab != NULL)
+        {
+            /* a slab kept from before the last reset */
+            slab->used = 0;
+        }
+    }
+
+    slab = create_slab(CJSON_POOL_SLAB_SIZE, CJSON_POOL_ALIGNMENT);
+    if (slab == NULL)
+    {
+        return NULL;
+    }
+    if (last == NULL)
+    {
+        chain->first = slab;
+    }
+    else
+    {
+        last->next = slab;
+    }
+    chain->current = slab;
+    slab->used = size;
+
+    return slab->data;
+}
+
+static cJSON *pool_new_item(cJSON_Pool * const pool)
+{
+    cJSON *node = (cJSON*)chain_allocate(&pool->nodes, sizeof(cJSON), sizeof(double));
+    if (node)
+    {
+        memset(node, '\0', sizeof(cJSON));
+    }
+
+    return node;
+}
+
+static unsigned char *pool_allocate_string(cJSON_Pool * const pool, size_t size)
+{
+    pool_slab *slab = NULL;
+    if (size <= CJSON_POOL_SLAB_SIZE / 4)
+    {
+        return (unsigned char*)chain_allocate(&pool->strings, size, 1);
+    }
+
+    /* a long string would waste most of a shared slab */
+    slab = create_slab(size, 1);
+    if (slab == NULL)
+    {
+        return NULL;
+    }
+    slab->used = size;
+    slab->next = pool->large;
+    pool->large = slab;
+
+    return slab->data;
+}
+
+CJSON_PUBLIC(cJSON_Pool *) cJSON_CreatePool(void)
+{
+    cJSON_Pool *pool = (cJSON_Pool*)global_hooks.allocate(sizeof(cJSON_Pool));
+    if (pool)
+    {
+        memset(pool, '\0', sizeof(cJSON_Pool));
+    }
+
+    return pool;
+}
+
+CJSON_PUBLIC(void) cJSON_ResetPool(cJSON_Pool *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    pool->nodes.current = pool->nodes.first;
+    if (pool->nodes.first != NULL)
+    {
+        pool->nodes.first->used = 0;
+    }
+    pool->strings.current = pool->strings.first;
+    if (pool->strings.first != NULL)
+    {
+        pool->strings.first->used = 0;
+    }
+    free_slabs(pool->large);
+    pool->large = NULL;
+}
+
+CJSON_PUBLIC(void) cJSON_DeletePool(cJSON_Pool *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    free_slabs(pool->nodes.first);
+    free_slabs(pool->strings.first);
+    free_slabs(pool->large);
+    global_hooks.deallocate(pool);
+}
+
 /* get the decimal point character of the current locale */
 static unsigned char get_decimal_point(void)
 {
@@ -293,8 +472,30 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    cJSON_Pool *pool; /* nodes and strings come from here instead of the hooks when set */
+    cJSON_bool in_situ; /* strings are unescaped inside content and point into it, see cJSON_ParseInSitu */
 } parse_buffer;
 
+/* allocate a node of the document being parsed */
+static cJSON *parse_new_item(parse_buffer * const input_buffer)
+{
+    if (input_buffer->pool != NULL)
+    {
+        return pool_new_item(input_buffer->pool);
+    }
+
+    return cJSON_New_Item(&(input_buffer->hooks));
+}
+
+/* free the part of a document that failed to parse, pooled nodes wait for the reset */
+static void parse_delete(parse_buffer * const input_buffer, cJSON *item)
+{
+    if (input_buffer->pool == NULL)
+    {
+        cJSON_Delete(item);
+    }
+}
+
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
 #define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
 /* check if the buffer can be accessed at the given index (starting with 0) */
@@ -815,6 +1016,78 @@ fail:
     return 0;
 }
 
+/* Vectorized scanning of string contents: SSE2 is part of every x86-64 CPU, AVX2 is picked at run time when the CPU has it. Define CJSON_NO_SIMD to only use the scalar loop. */
+#if !defined(CJSON_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define CJSON_SIMD_X86
+#include <immintrin.h>
+#endif
+/* plain bytes in a row after which parse_string stops going byte by byte and scans ahead */
+#define CJSON_WIDE_RUN 16
+
+/* scalar fallback and tail of the vector loops */
+static const unsigned char *find_quote_or_backslash_scalar(const unsigned char *pointer, const unsigned char * const end)
+{
+    while ((pointer < end) && (*pointer != '\"') && (*pointer != '\\'))
+    {
+        pointer++;
+    }
+
+    return pointer;
+}
+
+#ifdef CJSON_SIMD_X86
+static const unsigned char *find_quote_or_backslash_sse2(const unsigned char *pointer, const unsigned char * const end)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while ((size_t)(end - pointer) >= 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(const void*)pointer);
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+        if (mask != 0)
+        {
+            return pointer + __builtin_ctz(mask);
+        }
+        pointer += 16;
+    }
+
+    return find_quote_or_backslash_scalar(pointer, end);
+}
+
+__attribute__((target("avx2")))
+static const unsigned char *find_quote_or_backslash_avx2(const unsigned char *pointer, const unsigned char * const end)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    while ((size_t)(end - pointer) >= 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(const void*)pointer);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)));
+        if (mask != 0)
+        {
+            return pointer + __builtin_ctz(mask);
+        }
+        pointer += 32;
+    }
+
+    return find_quote_or_backslash_sse2(pointer, end);
+}
+#endif
+
+/* find the first quote or backslash in [pointer, end), returns end if there is none */
+static const unsigned char *find_quote_or_backslash(const unsigned char *pointer, const unsigned char * const end)
+{
+#ifdef CJSON_SIMD_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return find_quote_or_backslash_avx2(pointer, end);
+    }
+    return find_quote_or_backslash_sse2(pointer, end);
+#else
+    return find_quote_or_backslash_scalar(pointer, end);
+#endif
+}
+
 /* Parse the input text into an unescaped cinput, and populate item. */
 static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -822,6 +1095,8 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
     unsigned char *output_pointer = NULL;
     unsigned char *output = NULL;
+    size_t plain_run = 0;
+    size_t skipped_bytes = 0;
 
     /* not a string */
     if (buffer_at_offset(input_buffer)[0] != '\"')
@@ -832,30 +1107,50 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     {
         /* calculate approximate size of the output (overestimate) */
         size_t allocation_length = 0;
-        size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        const unsigned char * const buffer_end = input_buffer->content + input_buffer->length;
+        while ((input_end < buffer_end) && (*input_end != '\"'))
         {
             /* is escape sequence */
             if (input_end[0] == '\\')
             {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
+                if ((input_end + 1) >= buffer_end)
                 {
                     /* prevent buffer overflow when last input character is a backslash */
                     goto fail;
                 }
                 skipped_bytes++;
                 input_end++;
+                plain_run = 0;
+            }
+            else if (++plain_run == CJSON_WIDE_RUN)
+            {
+                /* a long run of plain text, skip the rest of it at once */
+                input_end = find_quote_or_backslash(input_end, buffer_end);
+                plain_run = 0;
+                continue;
             }
             input_end++;
         }
-        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
+        if ((input_end >= buffer_end) || (*input_end != '\"'))
         {
             goto fail; /* string ended unexpectedly */
         }
 
         /* This is at most how much we need for the output */
         allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        if (input_buffer->in_situ)
+        {
+            /* unescaping only ever shrinks the text, so it is written over the input it was read from, and the zero terminator at most replaces the closing quote */
+            output = (unsigned char*)input_pointer;
+        }
+        else if (input_buffer->pool != NULL)
+        {
+            output = pool_allocate_string(input_buffer->pool, allocation_length + sizeof(""));
+        }
+        else
+        {
+            output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        }
         if (output == NULL)
         {
             goto fail; /* allocation failure */
@@ -863,17 +1158,35 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     }
 
     output_pointer = output;
+    plain_run = 0;
+    if (input_buffer->in_situ && (skipped_bytes == 0))
+    {
+        /* nothing to unescape, the string is already in place */
+        output_pointer = (unsigned char*)input_end;
+        input_pointer = input_end;
+    }
     /* loop through the string literal */
     while (input_pointer < input_end)
     {
         if (*input_pointer != '\\')
         {
             *output_pointer++ = *input_pointer++;
+            if (++plain_run == CJSON_WIDE_RUN)
+            {
+                /* a long run of plain text, copy the rest of it at once */
+                const unsigned char *run_end = find_quote_or_backslash(input_pointer, input_end);
+                /* in place the output trails the input, so the two can overlap */
+                memmove(output_pointer, input_pointer, (size_t)(run_end - input_pointer));
+                output_pointer += run_end - input_pointer;
+                input_pointer = run_end;
+                plain_run = 0;
+            }
         }
         /* escape sequence */
         else
         {
             unsigned char sequence_length = 2;
+            plain_run = 0;
             if ((input_end - input_pointer) < 1)
             {
                 goto fail;
@@ -922,7 +1235,8 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     /* zero terminate the output */
     *output_pointer = '\0';
 
-    item->type = cJSON_String;
+    /* a string inside the input must not be freed by cJSON_Delete */
+    item->type = input_buffer->in_situ ? (cJSON_String | cJSON_IsReference) : cJSON_String;
     item->valuestring = (char*)output;
 
     input_buffer->offset = (size_t) (input_end - input_buffer->content);
@@ -931,7 +1245,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     return true;
 
 fail:
-    if (output != NULL)
+    if ((output != NULL) && (input_buffer->pool == NULL) && !input_buffer->in_situ)
     {
         input_buffer->hooks.deallocate(output);
         output = NULL;
@@ -945,15 +1259,264 @@ fail:
     return false;
 }
 
+/* scalar fallback and tail of the vector loops: find the first byte in [pointer, end) that has to be escaped in a JSON string */
+static const unsigned char *find_escape_scalar(const unsigned char *pointer, const unsigned char * const end)
+{
+    while ((pointer < end) && (*pointer > 31) && (*pointer != '\"') && (*pointer != '\\'))
+    {
+        pointer++;
+    }
+
+    return pointer;
+}
+
+#ifdef CJSON_SIMD_X86
+static const unsigned char *find_escape_sse2(const unsigned char *pointer, const unsigned char * const end)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(31);
+    while ((size_t)(end - pointer) >= 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(const void*)pointer);
+        /* unsigned byte <= 31 exactly when min(byte, 31) == byte */
+        __m128i special = _mm_cmpeq_epi8(_mm_min_epu8(block, control), block);
+        unsigned int mask = 0;
+        special = _mm_or_si128(special, _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+        mask = (unsigned int)_mm_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return pointer + __builtin_ctz(mask);
+        }
+        pointer += 16;
+    }
+
+    return find_escape_scalar(pointer, end);
+}
+
+__attribute__((target("avx2")))
+static const unsigned char *find_escape_avx2(const unsigned char *pointer, const unsigned char * const end)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(31);
+    while ((size_t)(end - pointer) >= 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(const void*)pointer);
+        __m256i special = _mm256_cmpeq_epi8(_mm256_min_epu8(block, control), block);
+        unsigned int mask = 0;
+        special = _mm256_or_si256(special, _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)));
+        mask = (unsigned int)_mm256_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return pointer + __builtin_ctz(mask);
+        }
+        pointer += 32;
+    }
+
+    return find_escape_sse2(pointer, end);
+}
+#endif
+
+/* find the first byte in [pointer, end) that has to be escaped, returns end if there is none */
+static const unsigned char *find_escape(const unsigned char *pointer, const unsigned char * const end)
+{
+#ifdef CJSON_SIMD_X86
+    /* escapes close together are found sooner byte by byte than by starting a vector scan */
+    const unsigned char *lead_end = ((size_t)(end - pointer) > CJSON_WIDE_RUN) ? pointer + CJSON_WIDE_RUN : end;
+    pointer = find_escape_scalar(pointer, lead_end);
+    if (pointer != lead_end)
+    {
+        return pointer;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return find_escape_avx2(pointer, end);
+    }
+    return find_escape_sse2(pointer, end);
+#else
+    return find_escape_scalar(pointer, end);
+#endif
+}
+
+/* bytes escaping adds to a character: \uXXXX for control characters without a short form, a backslash for the rest */
+static size_t escape_extra(const unsigned char c)
+{
+    if ((c < 32) && (c != '\b') && (c != '\f') && (c != '\n') && (c != '\r') && (c != '\t'))
+    {
+        return 5;
+    }
+
+    return ((c < 32) || (c == '\"') || (c == '\\')) ? 1 : 0;
+}
+
+/* scalar fallback and tail of the vector loops: bytes escaping adds to [pointer, end) */
+static size_t count_escape_extra_scalar(const unsigned char *pointer, const unsigned char * const end)
+{
+    size_t extra = 0;
+    for (; pointer < end; pointer++)
+    {
+        extra += escape_extra(*pointer);
+    }
+
+    return extra;
+}
+
+#ifdef CJSON_SIMD_X86
+static size_t count_escape_extra_sse2(const unsigned char *pointer, const unsigned char * const end)
+{
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(31);
+    size_t extra = 0;
+    while ((size_t)(end - pointer) >= 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(const void*)pointer);
+        unsigned int controls = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(block, control), block));
+        unsigned int others = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+        extra += (size_t)__builtin_popcount(others);
+        /* control characters are rare, look at them one by one */
+        while (controls != 0)
+        {
+            extra += escape_extra(pointer[__builtin_ctz(controls)]);
+            controls &= controls - 1;
+        }
+        pointer += 16;
+    }
+
+    return extra + count_escape_extra_scalar(pointer, end);
+}
+
+__attribute__((target("avx2")))
+static size_t count_escape_extra_avx2(const unsigned char *pointer, const unsigned char * const end)
+{
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(31);
+    size_t extra = 0;
+    while ((size_t)(end - pointer) >= 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(const void*)pointer);
+        unsigned int controls = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(block, control), block));
+        unsigned int others = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)));
+        extra += (size_t)__builtin_popcount(others);
+        while (controls != 0)
+        {
+            extra += escape_extra(pointer[__builtin_ctz(controls)]);
+            controls &= controls - 1;
+        }
+        pointer += 32;
+    }
+
+    return extra + count_escape_extra_sse2(pointer, end);
+}
+#endif
+
+/* bytes escaping adds to [pointer, end), for measuring strings before printing them */
+static size_t count_escape_extra(const unsigned char *pointer, const unsigned char * const end)
+{
+#ifdef CJSON_SIMD_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return count_escape_extra_avx2(pointer, end);
+    }
+    return count_escape_extra_sse2(pointer, end);
+#else
+    return count_escape_extra_scalar(pointer, end);
+#endif
+}
+
+/* write the escape sequence of c, which find_escape stopped at, to output. It takes 1 + escape_extra(c) bytes. */
+static void write_escape(unsigned char * const output, const unsigned char c)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+
+    output[0] = '\\';
+    switch (c)
+    {
+        case '\\':
+            output[1] = '\\';
+            break;
+        case '\"':
+            output[1] = '\"';
+            break;
+        case '\b':
+            output[1] = 'b';
+            break;
+        case '\f':
+            output[1] = 'f';
+            break;
+        case '\n':
+            output[1] = 'n';
+            break;
+        case '\r':
+            output[1] = 'r';
+            break;
+        case '\t':
+            output[1] = 't';
+            break;
+        default:
+            /* escape and print as unicode codepoint */
+            output[1] = 'u';
+            output[2] = '0';
+            output[3] = '0';
+            output[4] = hex_digits[c >> 4];
+            output[5] = hex_digits[c & 0x0F];
+            break;
+    }
+}
+
+CJSON_PUBLIC(size_t) cJSON_EscapedLength(const char *string, size_t length)
+{
+    const unsigned char *input = (const unsigned char*)string;
+
+    if (string == NULL)
+    {
+        return 0;
+    }
+
+    return length + count_escape_extra(input, input + length);
+}
+
+CJSON_PUBLIC(char *) cJSON_WriteEscaped(char *output, const char *string, size_t length)
+{
+    const unsigned char *input_pointer = (const unsigned char*)string;
+    const unsigned char *input_end = input_pointer + length;
+    const unsigned char *run_end = NULL;
+    size_t run_length = 0;
+
+    if ((output == NULL) || (string == NULL))
+    {
+        return output;
+    }
+
+    /* the same runs and escapes as print_string_ptr, the room was measured up front */
+    for (;;)
+    {
+        run_end = find_escape(input_pointer, input_end);
+        run_length = (size_t)(run_end - input_pointer);
+        memcpy(output, input_pointer, run_length);
+        output += run_length;
+        if (run_end == input_end)
+        {
+            return output;
+        }
+        write_escape((unsigned char*)output, *run_end);
+        output += 1 + escape_extra(*run_end);
+        input_pointer = run_end + 1;
+    }
+}
+
 /* Render the cstring provided to an escaped version that can be printed. */
+/* Works in one pass: runs of bytes that need no escaping are found a block at a time and copied with memcpy, the escapes are written in between. The output buffer offset is advanced as it goes. */
 static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
 {
     const unsigned char *input_pointer = NULL;
+    const unsigned char *input_end = NULL;
+    const unsigned char *run_end = NULL;
     unsigned char *output = NULL;
-    unsigned char *output_pointer = NULL;
-    size_t output_length = 0;
-    /* numbers of additional characters needed for escaping */
-    size_t escape_characters = 0;
+    size_t run_length = 0;
+    size_t escape_length = 0;
 
     if (output_buffer == NULL)
     {
@@ -973,101 +1536,56 @@ static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffe
         return true;
     }
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
-    {
-        switch (*input_pointer)
-        {
-            case '\"':
-            case '\\':
-            case '\b':
-            case '\f':
-            case '\n':
-            case '\r':
-            case '\t':
-                /* one character escape sequence */
-                escape_characters++;
-                break;
-            default:
-                if (*input_pointer < 32)
-                {
-                    /* UTF-16 escape sequence uXXXX */
-                    escape_characters += 5;
-                }
-                break;
-        }
-    }
-    output_length = (size_t)(input_pointer - input) + escape_characters;
-
-    output = ensure(output_buffer, output_length + sizeof("\"\""));
+    output = ensure(output_buffer, 1);
     if (output == NULL)
     {
         return false;
     }
+    output[0] = '\"';
+    output_buffer->offset++;
 
-    /* no characters have to be escaped */
-    if (escape_characters == 0)
+    input_end = input + strlen((const char*)input);
+    for (input_pointer = input; ; input_pointer = run_end + 1)
     {
-        output[0] = '\"';
-        memcpy(output + 1, input, output_length);
-        output[output_length + 1] = '\"';
-        output[output_length + 2] = '\0';
-
-        return true;
-    }
+        run_end = find_escape(input_pointer, input_end);
+        run_length = (size_t)(run_end - input_pointer);
+        escape_length = 0;
+        if (run_end != input_end)
+        {
+            escape_length = 1 + escape_extra(*run_end);
+        }
+        if ((run_length + escape_length) == 0)
+        {
+            break;
+        }
 
-    output[0] = '\"';
-    output_pointer = output + 1;
-    /* copy the string */
-    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
-    {
-        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
+        /* room for the run of normal characters and the escape after it */
+        output = ensure(output_buffer, run_length + escape_length);
+        if (output == NULL)
         {
-            /* normal character, copy */
-            *output_pointer = *input_pointer;
+            return false;
         }
-        else
+        memcpy(output, input_pointer, run_length);
+        output_buffer->offset += run_length + escape_length;
+        if (escape_length == 0)
         {
-            /* character needs to be escaped */
-            *output_pointer++ = '\\';
-            switch (*input_pointer)
-            {
-                case '\\':
-                    *output_pointer = '\\';
-                    break;
-                case '\"':
-                    *output_pointer = '\"';
-                    break;
-                case '\b':
-                    *output_pointer = 'b';
-                    break;
-                case '\f':
-                    *output_pointer = 'f';
-                    break;
-                case '\n':
-                    *output_pointer = 'n';
-                    break;
-                case '\r':
-                    *output_pointer = 'r';
-                    break;
-                case '\t':
-                    *output_pointer = 't';
-                    break;
-                default:
-                    /* escape and print as unicode codepoint */
-                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
-                    output_pointer += 4;
-                    break;
-            }
+            break;
         }
+
+        write_escape(output + run_length, *run_end);
     }
-    output[output_length + 1] = '\"';
-    output[output_length + 2] = '\0';
+
+    output = ensure(output_buffer, 1);
+    if (output == NULL)
+    {
+        return false;
+    }
+    output[0] = '\"';
+    output[1] = '\0';
 
     return true;
 }
 
-/* Invoke print_string_ptr (which is useful) on an item. */
 static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
 {
     return print_string_ptr((unsigned char*)item->valuestring, p);
@@ -1138,10 +1656,32 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
     return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
 }
 
+static cJSON *parse_document(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_Pool *pool, cJSON_bool in_situ);
+
 /* Parse an object - create a new root, and populate. */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    return parse_document(value, buffer_length, return_parse_end, require_null_terminated, NULL, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithPool(cJSON_Pool *pool, const char *value, size_t buffer_length)
+{
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+
+    return parse_document(value, buffer_length, NULL, false, pool, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length)
+{
+    return parse_document(value, buffer_length, NULL, false, NULL, true);
+}
+
+static cJSON *parse_document(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_Pool *pool, cJSON_bool in_situ)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, NULL, false };
     cJSON *item = NULL;
 
     /* reset error position */
@@ -1157,8 +1697,10 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.length = buffer_length;
     buffer.offset = 0;
     buffer.hooks = global_hooks;
+    buffer.pool = pool;
+    buffer.in_situ = in_situ;
 
-    item = cJSON_New_Item(&global_hooks);
+    item = parse_new_item(&buffer);
     if (item == NULL) /* memory fail */
     {
         goto fail;
@@ -1189,7 +1731,7 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
 fail:
     if (item != NULL)
     {
-        cJSON_Delete(item);
+        parse_delete(&buffer, item);
     }
 
     if (value != NULL)
@@ -1231,17 +1773,155 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 
 #define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
 
+/* Measuring pass: the length of the text print_value would write for an item, without the terminating zero, so print can allocate once. It has to follow the print_* functions above exactly. */
+static cJSON_bool measure_value(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length);
+
+static size_t measure_string_ptr(const unsigned char * const input)
+{
+    size_t length = 0;
+
+    if (input == NULL)
+    {
+        return sizeof("\"\"") - 1;
+    }
+
+    length = strlen((const char*)input);
+    return sizeof("\"\"") - 1 + length + count_escape_extra(input, input + length);
+}
+
+static cJSON_bool measure_number(const cJSON * const item, size_t * const length)
+{
+    /* the shortest round-tripping form is only known after printing it, print_number does that into a scratch buffer */
+    unsigned char scratch[32];
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+
+    p.buffer = scratch;
+    p.length = sizeof(scratch);
+    p.noalloc = true;
+    if (!print_number(item, &p))
+    {
+        return false;
+    }
+    *length += p.offset;
+
+    return true;
+}
+
+static cJSON_bool measure_array(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length)
+{
+    const cJSON *current_element = item->child;
+
+    *length += sizeof("[]") - 1;
+    while (current_element != NULL)
+    {
+        if (!measure_value(current_element, format, depth + 1, length))
+        {
+            return false;
+        }
+        if (current_element->next != NULL)
+        {
+            *length += format ? sizeof(", ") - 1 : sizeof(",") - 1;
+        }
+        current_element = current_element->next;
+    }
+
+    return true;
+}
+
+static cJSON_bool measure_object(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length)
+{
+    const cJSON *current_item = item->child;
+
+    /* fmt: {\n, then the closing brace indented to the depth of the object */
+    *length += format ? (sizeof("{\n}") - 1 + depth) : sizeof("{}") - 1;
+    while (current_item != NULL)
+    {
+        if (format)
+        {
+            /* indentation, ":\t" and the newline after the value */
+            *length += (depth + 1) + 3;
+        }
+        else
+        {
+            *length += sizeof(":") - 1;
+        }
+        *length += measure_string_ptr((const unsigned char*)current_item->string);
+        if (!measure_value(current_item, format, depth + 1, length))
+        {
+            return false;
+        }
+        if (current_item->next != NULL)
+        {
+            *length += sizeof(",") - 1;
+        }
+        current_item = current_item->next;
+    }
+
+    return true;
+}
+
+static cJSON_bool measure_value(const cJSON * const item, const cJSON_bool format, const size_t depth, size_t * const length)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    switch ((item->type) & 0xFF)
+    {
+        case cJSON_NULL:
+        case cJSON_True:
+            *length += sizeof("null") - 1;
+            return true;
+
+        case cJSON_False:
+            *length += sizeof("false") - 1;
+            return true;
+
+        case cJSON_Number:
+            return measure_number(item, length);
+
+        case cJSON_Raw:
+            if (item->valuestring == NULL)
+            {
+                return false;
+            }
+            *length += strlen(item->valuestring);
+            return true;
+
+        case cJSON_String:
+            *length += measure_string_ptr((const unsigned char*)item->valuestring);
+            return true;
+
+        case cJSON_Array:
+            return measure_array(item, format, depth, length);
+
+        case cJSON_Object:
+            return measure_object(item, format, depth, length);
+
+        default:
+            return false;
+    }
+}
+
 static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
 {
-    static const size_t default_buffer_size = 256;
+    /* the print functions reserve a byte past the terminating zero when closing a value */
+    static const size_t print_slack = 2;
     printbuffer buffer[1];
-    unsigned char *printed = NULL;
+    size_t printed_length = 0;
 
     memset(buffer, 0, sizeof(buffer));
 
+    /* measure first, so the text is written into a single allocation of the right size instead of a buffer that keeps doubling */
+    if (!measure_value(item, format, 0, &printed_length) || (printed_length > (INT_MAX - print_slack)))
+    {
+        goto fail;
+    }
+
     /* create buffer */
-    buffer->buffer = (unsigned char*) hooks->allocate(default_buffer_size);
-    buffer->length = default_buffer_size;
+    buffer->buffer = (unsigned char*) hooks->allocate(printed_length + print_slack);
+    buffer->length = printed_length + print_slack;
     buffer->format = format;
     buffer->hooks = *hooks;
     if (buffer->buffer == NULL)
@@ -1256,31 +1936,7 @@ static unsigned char *print(const cJSON * const item, cJSON_bool format, const i
     }
     update_offset(buffer);
 
-    /* check if reallocate is available */
-    if (hooks->reallocate != NULL)
-    {
-        printed = (unsigned char*) hooks->reallocate(buffer->buffer, buffer->offset + 1);
-        if (printed == NULL) {
-            goto fail;
-        }
-        buffer->buffer = NULL;
-    }
-    else /* otherwise copy the JSON over to a new buffer */
-    {
-        printed = (unsigned char*) hooks->allocate(buffer->offset + 1);
-        if (printed == NULL)
-        {
-            goto fail;
-        }
-        memcpy(printed, buffer->buffer, cjson_min(buffer->length, buffer->offset + 1));
-        printed[buffer->offset] = '\0'; /* just to be sure */
-
-        /* free the buffer */
-        hooks->deallocate(buffer->buffer);
-        buffer->buffer = NULL;
-    }
-
-    return printed;
+    return buffer->buffer;
 
 fail:
     if (buffer->buffer != NULL)
@@ -1289,12 +1945,6 @@ fail:
         buffer->buffer = NULL;
     }
 
-    if (printed != NULL)
-    {
-        hooks->deallocate(printed);
-        printed = NULL;
-    }
-
     return NULL;
 }
 
@@ -1340,6 +1990,18 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
     return (char*)p.buffer;
 }
 
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool format)
+{
+    size_t length = 0;
+
+    if (!measure_value(item, format, 0, &length))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
 {
     printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
@@ -1527,7 +2189,7 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
     do
     {
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        cJSON *new_item = parse_new_item(input_buffer);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1580,7 +2242,7 @@ success:
 fail:
     if (head != NULL)
     {
-        cJSON_Delete(head);
+        parse_delete(input_buffer, head);
     }
 
     return false;
@@ -1685,7 +2347,7 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
     do
     {
         /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
+        cJSON *new_item = parse_new_item(input_buffer);
         if (new_item == NULL)
         {
             goto fail; /* allocation failure */
@@ -1722,6 +2384,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* swap valuestring and string, because we parsed the name */
         current_item->string = current_item->valuestring;
         current_item->valuestring = NULL;
+        if (input_buffer->in_situ)
+        {
+            /* the name points into the input, keep cJSON_Delete from freeing it */
+            current_item->type = cJSON_StringIsConst;
+        }
 
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
@@ -1735,6 +2402,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         {
             goto fail; /* failed to parse value */
         }
+        if (input_buffer->in_situ)
+        {
+            /* parse_value set the type anew */
+            current_item->type |= cJSON_StringIsConst;
+        }
         buffer_skip_whitespace(input_buffer);
     }
     while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
@@ -1760,7 +2432,7 @@ success:
 fail:
     if (head != NULL)
     {
-        cJSON_Delete(head);
+        parse_delete(input_buffer, head);
     }
 
     return false;
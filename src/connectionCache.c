@@ -0,0 +1,267 @@
+#include "connectionCache.h"
+
+#include <fcntl.h>  // For open()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>  // For mkdir()
+#include <time.h>
+#include <unistd.h>  // For getpid()
+
+// First line of the file, bumped whenever the format changes
+#define CONNECTION_FILE_HEADER "askai-connections 1"
+
+// TLS session export and import appeared in libcurl 8.12
+#if LIBCURL_VERSION_NUM >= 0x080c00
+#define HAVE_SSLS_EXPORT 1
+#endif
+
+static void lockShare(CURL *handle, curl_lock_data data,
+                      curl_lock_access access, void *userp) {
+    (void)handle;
+    (void)access;
+    pthread_mutex_lock(&((struct ConnectionCache *)userp)->locks[data]);
+}
+
+static void unlockShare(CURL *handle, curl_lock_data data, void *userp) {
+    (void)handle;
+    pthread_mutex_unlock(&((struct ConnectionCache *)userp)->locks[data]);
+}
+
+#ifdef HAVE_SSLS_EXPORT
+static void writeHex(FILE *file, const unsigned char *data, size_t length) {
+    for (size_t i = 0; i < length; i++)
+        fprintf(file, "%02x", data[i]);
+}
+
+// helper to decode a hex string in place, returns the number of bytes
+static size_t decodeHex(char *text) {
+    size_t length = strlen(text) / 2;
+    unsigned char *out = (unsigned char *)text;
+    for (size_t i = 0; i < length; i++) {
+        unsigned int byte;
+        if (sscanf(text + 2 * i, "%2x", &byte) != 1)
+            return 0;
+        out[i] = (unsigned char)byte;
+    }
+    return length;
+}
+
+static CURLcode exportSession(CURL *handle, void *userp,
+                              const char *session_key,
+                              const unsigned char *shmac, size_t shmac_len,
+                              const unsigned char *sdata, size_t sdata_len,
+                              curl_off_t valid_until, int ietf_tls_id,
+                              const char *alpn, size_t earlydata_max) {
+    (void)handle;
+    (void)session_key;  // it names the peer in clear text, the hmac is enough
+    (void)ietf_tls_id;
+    (void)alpn;
+    (void)earlydata_max;
+    FILE *file = userp;
+    fprintf(file, "tls %lld ", (long long)valid_until);
+    writeHex(file, shmac, shmac_len);
+    fputc(' ', file);
+    writeHex(file, sdata, sdata_len);
+    fputc('\n', file);
+    return CURLE_OK;
+}
+
+// helper to get a short lived handle attached to the share, sessions are
+// imported and exported through a handle
+static CURL *shareHandle(struct ConnectionCache *cache) {
+    CURL *curl = curl_easy_init();
+    if (curl)
+        curl_easy_setopt(curl, CURLOPT_SHARE, cache->share);
+    return curl;
+}
+#endif
+
+// helper to read the file, expired addresses and sessions are skipped
+static void loadConnections(struct ConnectionCache *cache) {
+    FILE *file = fopen(cache->path, "r");
+    if (!file)
+        return;
+
+    char line[16384];
+    if (!fgets(line, sizeof(line), file) ||
+        strncmp(line, CONNECTION_FILE_HEADER, strlen(CONNECTION_FILE_HEADER)) !=
+            0) {
+        fclose(file);
+        return;
+    }
+
+#ifdef HAVE_SSLS_EXPORT
+    CURL *importer = shareHandle(cache);
+#endif
+    time_t now = time(NULL);
+    while (fgets(line, sizeof(line), file)) {
+        char host[256], address[64];
+        long port;
+        long long stamp;
+        if (sscanf(line, "resolve %255s %ld %63s %lld", host, &port, address,
+                   &stamp) == 4) {
+            if (now - stamp >= CONNECTION_DNS_TTL)
+                continue;
+            // "+" lets libcurl expire the entry like any lookup it made itself,
+            // IPv6 addresses have to be bracketed
+            char entry[400];
+            snprintf(entry, sizeof(entry),
+                     strchr(address, ':') ? "+%s:%ld:[%s]" : "+%s:%ld:%s", host,
+                     port, address);
+            cache->resolve = curl_slist_append(cache->resolve, entry);
+            snprintf(cache->host, sizeof(cache->host), "%s", host);
+            snprintf(cache->address, sizeof(cache->address), "%s", address);
+            cache->port = port;
+            cache->resolvedAt = (time_t)stamp;
+            continue;
+        }
+#ifdef HAVE_SSLS_EXPORT
+        if (importer && strncmp(line, "tls ", 4) == 0) {
+            char *fields;
+            long long validUntil = strtoll(line + 4, &fields, 10);
+            char *shmac = strtok(fields, " \n");
+            char *sdata = strtok(NULL, " \n");
+            if (validUntil <= now || !shmac || !sdata)
+                continue;
+            size_t shmac_len = decodeHex(shmac);
+            size_t sdata_len = decodeHex(sdata);
+            curl_easy_ssls_import(importer, NULL, (unsigned char *)shmac,
+                                  shmac_len, (unsigned char *)sdata, sdata_len);
+        }
+#endif
+    }
+#ifdef HAVE_SSLS_EXPORT
+    if (importer)
+        curl_easy_cleanup(importer);
+#endif
+    fclose(file);
+}
+
+int openConnectionCache(struct ConnectionCache *cache, int shareConnections) {
+    memset(cache, 0, sizeof(*cache));
+    cache->share = curl_share_init();
+    if (!cache->share)
+        return 0;
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        pthread_mutex_init(&cache->locks[i], NULL);
+    pthread_mutex_init(&cache->mutex, NULL);
+
+    curl_share_setopt(cache->share, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(cache->share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(cache->share, CURLSHOPT_USERDATA, cache);
+    curl_share_setopt(cache->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(cache->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    if (shareConnections)
+        curl_share_setopt(cache->share, CURLSHOPT_SHARE,
+                          CURL_LOCK_DATA_CONNECT);
+
+    // The file lives next to the config file written by getApiKey
+    const char *home_dir = getenv("HOME");
+    if (home_dir && snprintf(cache->path, sizeof(cache->path),
+                             "%s/.askai-cli/connections",
+                             home_dir) < (int)sizeof(cache->path))
+        loadConnections(cache);
+    else
+        cache->path[0] = '\0';
+    return 1;
+}
+
+void applyConnectionCache(struct ConnectionCache *cache, CURL *curl) {
+    if (!cache || !cache->share)
+        return;
+    curl_easy_setopt(curl, CURLOPT_SHARE, cache->share);
+    if (cache->resolve)
+        curl_easy_setopt(curl, CURLOPT_RESOLVE, cache->resolve);
+}
+
+void rememberConnection(struct ConnectionCache *cache, CURL *curl) {
+    if (!cache || !cache->share)
+        return;
+
+    char *url = NULL, *ip = NULL;
+    long port = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url) != CURLE_OK ||
+        curl_easy_getinfo(curl, CURLINFO_PRIMARY_IP, &ip) != CURLE_OK ||
+        curl_easy_getinfo(curl, CURLINFO_PRIMARY_PORT, &port) != CURLE_OK ||
+        !url || !ip || !ip[0])
+        return;
+
+    CURLU *parsed = curl_url();
+    char *host = NULL;
+    if (parsed && curl_url_set(parsed, CURLUPART_URL, url, 0) == CURLUE_OK)
+        curl_url_get(parsed, CURLUPART_HOST, &host, 0);
+
+    // A numeric host needs no lookup, e.g. a local mock server
+    if (host && strcmp(host, ip) != 0 && host[0] != '[') {
+        pthread_mutex_lock(&cache->mutex);
+        time_t now = time(NULL);
+        if (strcmp(cache->host, host) != 0 || cache->port != port ||
+            strcmp(cache->address, ip) != 0 ||
+            now - cache->resolvedAt >= CONNECTION_DNS_TTL / 2) {
+            snprintf(cache->host, sizeof(cache->host), "%s", host);
+            snprintf(cache->address, sizeof(cache->address), "%s", ip);
+            cache->port = port;
+            cache->resolvedAt = now;
+            cache->dirty = 1;
+        }
+        pthread_mutex_unlock(&cache->mutex);
+    }
+    curl_free(host);
+    curl_url_cleanup(parsed);
+}
+
+void closeConnectionCache(struct ConnectionCache *cache) {
+    if (!cache->share)
+        return;
+
+#ifdef HAVE_SSLS_EXPORT
+    // Sessions change with every handshake, so they are always written back
+    int write = cache->path[0] != '\0';
+#else
+    int write = cache->path[0] != '\0' && cache->dirty;
+#endif
+    if (write) {
+        char dir[1024], tmp[1100];
+        snprintf(dir, sizeof(dir), "%s", cache->path);
+        char *slash = strrchr(dir, '/');
+        if (slash) {
+            *slash = '\0';
+            mkdir(dir, 0700);  // ignore errors if it already exists
+        }
+        snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", cache->path, (long)getpid());
+        // Session tickets are secrets, so the file is private to the user
+        // from the moment it is created
+        int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        FILE *file = fd >= 0 ? fdopen(fd, "w") : NULL;
+        if (!file && fd >= 0) {
+            close(fd);
+            unlink(tmp);
+        }
+        if (file) {
+            fprintf(file, "%s\n", CONNECTION_FILE_HEADER);
+            if (cache->host[0] && time(NULL) - cache->resolvedAt <
+                                      CONNECTION_DNS_TTL)
+                fprintf(file, "resolve %s %ld %s %lld\n", cache->host,
+                        cache->port, cache->address,
+                        (long long)cache->resolvedAt);
+#ifdef HAVE_SSLS_EXPORT
+            CURL *exporter = shareHandle(cache);
+            if (exporter) {
+                curl_easy_ssls_export(exporter, exportSession, file);
+                curl_easy_cleanup(exporter);
+            }
+#endif
+            if (fclose(file) != 0 || rename(tmp, cache->path) != 0)
+                unlink(tmp);
+        }
+    }
+
+    curl_share_cleanup(cache->share);
+    cache->share = NULL;
+    curl_slist_free_all(cache->resolve);
+    cache->resolve = NULL;
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        pthread_mutex_destroy(&cache->locks[i]);
+    pthread_mutex_destroy(&cache->mutex);
+}
@@ -0,0 +1,367 @@
+#include "daemon.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>  // For mkdir() and chmod()
+#include <sys/time.h>  // For the receive timeout
+#include <sys/un.h>
+#include <unistd.h>
+
+// First word of every message, bumped if the protocol ever changes
+#define DAEMON_PROTOCOL "ASKAI1"
+// A client that stops sending for this long is dropped so the next one is
+// not kept waiting
+#define DAEMON_CLIENT_TIMEOUT_S 5
+// The daemon serves one client at a time, so a PING that is not answered
+// this quickly means it is busy and the request goes out directly instead
+#define DAEMON_PING_TIMEOUT_MS 200
+
+// Largest request body a client may send, anything bigger is refused
+#define DAEMON_MAX_REQUEST_BYTES (64UL * 1024 * 1024)
+
+// While relaying, the cancel flag is checked at least this often
+#define RELAY_CANCEL_POLL_MS 20
+
+// Protocol, one request per connection:
+//   client: "ASKAI1 PING <model> <base url>\n"   daemon: "OK\n" or "MISMATCH\n"
+//   client: "ASKAI1 REQ <streaming> <length>\n" followed by the request body
+//   daemon: the response body in frames of a 4 byte big endian length and
+//           that many bytes, an empty frame, then one line
+//           "<curl code> <http status> <dns> <connect> <tls> <ttfb>
+//            <transfer> <bytes sent> <bytes received>\n"
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int sig) {
+    (void)sig;
+    stopRequested = 1;
+}
+
+// helper to write a whole buffer, returns 0 if the peer went away
+static int writeAll(int fd, const void *data, size_t length) {
+    const char *p = data;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        length -= n;
+    }
+    return 1;
+}
+
+// helper to read exactly length bytes, returns 0 on end of stream or error
+static int readAll(int fd, void *data, size_t length) {
+    char *p = data;
+    while (length > 0) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        length -= n;
+    }
+    return 1;
+}
+
+// helper to read one short protocol line without its newline
+static int readLine(int fd, char *line, size_t size) {
+    size_t length = 0;
+    while (length + 1 < size) {
+        if (!readAll(fd, &line[length], 1))
+            return 0;
+        if (line[length] == '\n') {
+            line[length] = '\0';
+            return 1;
+        }
+        length++;
+    }
+    return 0;
+}
+
+static int writeFrame(int fd, const void *data, size_t length) {
+    unsigned char header[4] = {length >> 24, length >> 16, length >> 8,
+                               length};
+    return writeAll(fd, header, sizeof(header)) &&
+           (length == 0 || writeAll(fd, data, length));
+}
+
+static int connectDaemon(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int daemonSocketPath(char *path, size_t size) {
+    const char *home_dir = getenv("HOME");
+    if (!home_dir)
+        return 0;
+    int len = snprintf(path, size, "%s/.askai-cli/daemon.sock", home_dir);
+    return len > 0 && (size_t)len < size;
+}
+
+int daemonAvailable(const char *path, const struct ApiConfig *config) {
+    int fd = connectDaemon(path);
+    if (fd < 0)
+        return 0;
+    struct timeval timeout = {0, DAEMON_PING_TIMEOUT_MS * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char line[1024];
+    int len = snprintf(line, sizeof(line), "%s PING %s %s\n", DAEMON_PROTOCOL,
+                       config->model, config->baseUrl);
+    int ok = len > 0 && (size_t)len < sizeof(line) &&
+             writeAll(fd, line, len) && readLine(fd, line, sizeof(line)) &&
+             strcmp(line, "OK") == 0;
+    close(fd);
+    return ok;
+}
+
+// helper to wait until the daemon sends something, returns 0 once cancel is
+// set so the caller can hang up
+static int waitReadable(int fd, atomic_int *cancel) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    while (!atomic_load(cancel)) {
+        int ready = poll(&pfd, 1, RELAY_CANCEL_POLL_MS);
+        if (ready > 0 || (ready < 0 && errno != EINTR))
+            return 1;
+    }
+    return 0;
+}
+
+CURLcode relayRequest(const char *path, int streaming, const char *post_data,
+                      ResponseCallback callback, void *userp,
+                      struct TurnStats *stats, atomic_int *cancel) {
+    if (atomic_load(cancel))
+        return CURLE_ABORTED_BY_CALLBACK;
+    int fd = connectDaemon(path);
+    if (fd < 0)
+        return CURLE_COULDNT_CONNECT;
+
+    size_t length = strlen(post_data);
+    char line[256];
+    int len = snprintf(line, sizeof(line), "%s REQ %d %zu\n", DAEMON_PROTOCOL,
+                       streaming ? 1 : 0, length);
+    if (!writeAll(fd, line, len) || !writeAll(fd, post_data, length)) {
+        close(fd);
+        return CURLE_SEND_ERROR;
+    }
+
+    // Hand every frame to the callback as soon as it arrives, just like
+    // libcurl would
+    char block[16384];
+    while (1) {
+        // Hanging up is how a cancel reaches the daemon, it sees the socket
+        // close from its progress callback and aborts its transfer as well
+        if (!waitReadable(fd, cancel)) {
+            close(fd);
+            return CURLE_ABORTED_BY_CALLBACK;
+        }
+        unsigned char header[4];
+        if (!readAll(fd, header, sizeof(header))) {
+            close(fd);
+            return CURLE_RECV_ERROR;
+        }
+        size_t frame = (size_t)header[0] << 24 | (size_t)header[1] << 16 |
+                       (size_t)header[2] << 8 | header[3];
+        if (frame == 0)
+            break;
+        while (frame > 0) {
+            size_t n = frame < sizeof(block) ? frame : sizeof(block);
+            if (!readAll(fd, block, n)) {
+                close(fd);
+                return CURLE_RECV_ERROR;
+            }
+            if (callback(block, 1, n, userp) != n) {
+                close(fd);
+                return CURLE_WRITE_ERROR;
+            }
+            frame -= n;
+        }
+    }
+
+    int code = CURLE_RECV_ERROR;
+    if (readLine(fd, line, sizeof(line)))
+        sscanf(line, "%d %ld %lf %lf %lf %lf %lf %ld %ld", &code,
+               &stats->httpStatus, &stats->dnsMs, &stats->connectMs,
+               &stats->tlsMs, &stats->ttfbMs, &stats->transferMs,
+               &stats->requestBytes, &stats->responseBytes);
+    close(fd);
+    return (CURLcode)code;
+}
+
+// Write callback of the daemon, forwards the response to the client as it
+// arrives. Returning 0 when the client is gone makes libcurl abort.
+static size_t relayChunk(void *contents, size_t size, size_t nmemb,
+                         void *userp) {
+    size_t realsize = size * nmemb;
+    if (!writeFrame(*(int *)userp, contents, realsize))
+        return 0;
+    return realsize;
+}
+
+// Abort check of the daemon's requests: a client that hung up (e.g. on
+// Ctrl-C) gets nothing more, so its transfer is aborted right away instead
+// of at the next write, which a non-streaming request only does at the end
+static int clientGone(void *userp) {
+    struct pollfd pfd = {*(int *)userp, 0, 0};
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR));
+}
+
+// Serves one connection, a ping or a request
+static void serveClient(int fd, const struct ApiConfig *config,
+                        struct RequestContext *stream,
+                        struct RequestContext *plain) {
+    char line[1024];
+    if (!readLine(fd, line, sizeof(line)))
+        return;
+
+    char protocol[16], verb[16], arg1[256], arg2[768];
+    int fields = sscanf(line, "%15s %15s %255s %767s", protocol, verb, arg1,
+                        arg2);
+    if (fields < 2 || strcmp(protocol, DAEMON_PROTOCOL) != 0)
+        return;
+
+    if (strcmp(verb, "PING") == 0) {
+        // Only clients configured like the daemon may use it
+        int same = fields == 4 && strcmp(arg1, config->model) == 0 &&
+                   strcmp(arg2, config->baseUrl) == 0;
+        writeAll(fd, same ? "OK\n" : "MISMATCH\n", same ? 3 : 9);
+        return;
+    }
+    if (strcmp(verb, "REQ") != 0 || fields != 4)
+        return;
+
+    char *end;
+    errno = 0;
+    unsigned long length = strtoul(arg2, &end, 10);
+    if (errno != 0 || end == arg2 || *end != '\0' || arg2[0] == '-' ||
+        length > DAEMON_MAX_REQUEST_BYTES)
+        return;
+    char *body = malloc(length + 1);
+    if (!body)
+        return;
+    if (!readAll(fd, body, length)) {
+        free(body);
+        return;
+    }
+    body[length] = '\0';
+
+    struct RequestContext *ctx = atoi(arg1) ? stream : plain;
+    ctx->abortCheck = clientGone;
+    ctx->abortArg = &fd;
+    CURLcode res = performRequest(ctx, body, relayChunk, &fd);
+    ctx->abortCheck = NULL;
+    ctx->abortArg = NULL;
+    free(body);
+
+    struct TurnStats stats;
+    initTurnStats(&stats);
+    collectTransferStats(&stats, ctx->winner);
+    int len = snprintf(line, sizeof(line),
+                       "%d %ld %.3f %.3f %.3f %.3f %.3f %ld %ld\n", (int)res,
+                       stats.httpStatus, stats.dnsMs, stats.connectMs,
+                       stats.tlsMs, stats.ttfbMs, stats.transferMs,
+                       stats.requestBytes, stats.responseBytes);
+    if (writeFrame(fd, NULL, 0))
+        writeAll(fd, line, len);
+}
+
+int runDaemon(const char *path, const struct ApiConfig *config) {
+    // A second daemon would steal the socket of the first one
+    int probe = connectDaemon(path);
+    if (probe >= 0) {
+        close(probe);
+        fprintf(stderr, "An askai daemon is already listening on %s\n", path);
+        return 0;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Daemon socket path too long.\n");
+        return 0;
+    }
+    strcpy(addr.sun_path, path);
+
+    // The socket lives next to the config file, only the user may reach it
+    char dir[sizeof(addr.sun_path)];
+    strcpy(dir, path);
+    char *slash = strrchr(dir, '/');
+    if (slash) {
+        *slash = '\0';
+        mkdir(dir, 0700);  // ignore errors if it already exists
+    }
+    unlink(path);  // a stale socket left by a daemon that was killed
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 ||
+        bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        chmod(path, 0600) != 0 || listen(listener, 16) != 0) {
+        perror("askai daemon");
+        if (listener >= 0)
+            close(listener);
+        return 0;
+    }
+
+    // No SA_RESTART, so a signal interrupts accept() and ends the loop
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);  // clients that hang up show up as write errors
+
+    // One handle per response format; both go through the connection cache of
+    // the config, opened with connection sharing so either can use a
+    // connection the other opened
+    struct RequestContext stream, plain;
+    if (!initRequestContext(&stream, config, 1) ||
+        !initRequestContext(&plain, config, 0)) {
+        fprintf(stderr, "Failed due to some network related error\n");
+        close(listener);
+        unlink(path);
+        return 0;
+    }
+
+    // Connect right away so even the first client finds a warm connection
+    startWarmup(&stream);
+    fprintf(stderr, "askai daemon listening on %s\n", path);
+    while (!stopRequested) {
+        int client = accept(listener, NULL, NULL);
+        if (client < 0)
+            continue;
+        struct timeval timeout = {DAEMON_CLIENT_TIMEOUT_S, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        serveClient(client, config, &stream, &plain);
+        close(client);
+    }
+
+    close(listener);
+    unlink(path);
+    cleanupRequestContext(&stream);
+    cleanupRequestContext(&plain);
+    fprintf(stderr, "askai daemon stopped\n");
+    return 1;
+}
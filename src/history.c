@@ -0,0 +1,128 @@
+#include "history.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "requestWriter.h"
+
+// Rough per-turn cost of the role and parts wrapper around the text
+#define TURN_OVERHEAD_TOKENS 4
+
+void initHistory(struct ChatHistory *history) {
+    history->turns = NULL;
+    history->count = 0;
+    history->capacity = 0;
+    history->tokens = 0;
+    history->summary = NULL;
+    history->summaryTokens = 0;
+}
+
+size_t estimateTokens(const char *text, size_t length) {
+    // English text averages about 4 bytes per token, while bytes of multi
+    // byte UTF-8 characters tokenize far worse, so they are counted apart
+    size_t ascii = 0;
+    for (size_t i = 0; i < length; i++) {
+        if ((unsigned char)text[i] < 0x80)
+            ascii++;
+    }
+    return (ascii + 3) / 4 + (length - ascii + 1) / 2;
+}
+
+int addTurn(struct ChatHistory *history, const char *role, const char *text) {
+    if (history->count == history->capacity) {
+        int capacity = history->capacity ? history->capacity * 2 : 16;
+        struct Turn *turns =
+            realloc(history->turns, capacity * sizeof(struct Turn));
+        if (!turns)
+            return 0;
+        history->turns = turns;
+        history->capacity = capacity;
+    }
+
+    // The text is copied exactly once, with its length measured once
+    struct Turn *turn = &history->turns[history->count];
+    turn->length = strlen(text);
+    turn->role = strdup(role);
+    turn->text = malloc(turn->length + 1);
+    if (turn->text)
+        memcpy(turn->text, text, turn->length + 1);
+
+    // Escape the turn once now, every later request only copies the result
+    turn->entry = renderContentEntry(role, text, turn->length,
+                                     &turn->entryLength);
+    if (!turn->role || !turn->text || !turn->entry) {
+        free(turn->role);
+        free(turn->text);
+        free(turn->entry);
+        return 0;
+    }
+    turn->tokens = estimateTokens(text, turn->length) + TURN_OVERHEAD_TOKENS;
+    history->tokens += turn->tokens;
+    history->count++;
+    return 1;
+}
+
+void removeLastTurn(struct ChatHistory *history) {
+    if (history->count == 0)
+        return;
+    history->count--;
+    history->tokens -= history->turns[history->count].tokens;
+    free(history->turns[history->count].role);
+    free(history->turns[history->count].text);
+    free(history->turns[history->count].entry);
+}
+
+void freeHistory(struct ChatHistory *history) {
+    for (int i = 0; i < history->count; i++) {
+        free(history->turns[i].role);
+        free(history->turns[i].text);
+        free(history->turns[i].entry);
+    }
+    free(history->turns);
+    free(history->summary);
+    initHistory(history);
+}
+
+int compactHistory(struct ChatHistory *history, size_t budget,
+                   struct StringBuffer *dropped) {
+    int drop = 0;
+    size_t tokens = history->tokens + history->summaryTokens;
+
+    // Drop whole exchanges from the front so the history still starts with a
+    // user turn, but never the prompt that is about to be sent
+    while (tokens > budget && drop + 1 < history->count) {
+        int end = drop + 1;
+        while (end + 1 < history->count &&
+               strcmp(history->turns[end].role, "user") != 0)
+            end++;
+        for (; drop < end; drop++)
+            tokens -= history->turns[drop].tokens;
+    }
+    if (drop == 0)
+        return 0;
+
+    for (int i = 0; i < drop; i++) {
+        struct Turn *turn = &history->turns[i];
+        if (dropped) {
+            appendStringToBuffer(dropped, turn->role);
+            appendToBuffer(dropped, ": ", 2);
+            appendToBuffer(dropped, turn->text, turn->length);
+            appendToBuffer(dropped, "\n", 1);
+        }
+        history->tokens -= turn->tokens;
+        free(turn->role);
+        free(turn->text);
+        free(turn->entry);
+    }
+    history->count -= drop;
+    memmove(history->turns, history->turns + drop,
+            history->count * sizeof(struct Turn));
+    return drop;
+}
+
+void setHistorySummary(struct ChatHistory *history, char *summary) {
+    free(history->summary);
+    history->summary = summary;
+    history->summaryTokens =
+        summary ? estimateTokens(summary, strlen(summary)) : 0;
+}
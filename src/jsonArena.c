@@ -0,0 +1,116 @@
+#include "jsonArena.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "cJSON.h"
+
+// Every allocation is aligned like malloc's
+#define ARENA_ALIGN alignof(max_align_t)
+
+struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;  // usable bytes after the header
+    size_t used;
+    size_t last;  // offset of the newest allocation, for in-place frees
+    alignas(max_align_t) char data[];
+};
+
+// The arena cJSON allocates from on this thread, NULL to use malloc
+static _Thread_local struct JsonArena *currentArena = NULL;
+
+// helper to find the block of the current arena holding a pointer
+static struct ArenaBlock *owningBlock(struct JsonArena *arena, char *p) {
+    for (struct ArenaBlock *block = arena->blocks; block; block = block->next) {
+        if (p >= block->data && p < block->data + block->size)
+            return block;
+    }
+    return NULL;
+}
+
+static void *arenaAllocate(size_t size) {
+    struct JsonArena *arena = currentArena;
+    if (!arena)
+        return malloc(size);
+
+    size_t rounded = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    struct ArenaBlock *block = arena->blocks;
+    if (!block || block->size - block->used < rounded) {
+        size_t blockSize = block ? block->size * 2 : JSON_ARENA_BLOCK;
+        while (blockSize < rounded)
+            blockSize *= 2;
+        block = malloc(sizeof(struct ArenaBlock) + blockSize);
+        if (!block)
+            return NULL;
+        block->size = blockSize;
+        block->used = 0;
+        block->last = 0;
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+    void *p = block->data + block->used;
+    block->last = block->used;
+    block->used += rounded;
+    arena->allocations++;
+    arena->bytes += rounded;
+    return p;
+}
+
+static void arenaDeallocate(void *p) {
+    struct JsonArena *arena = currentArena;
+    struct ArenaBlock *block = arena ? owningBlock(arena, p) : NULL;
+    if (!block) {
+        // Allocated before the arena was active, or on another thread
+        free(p);
+        return;
+    }
+    // Most frees undo the allocation just made (temporary buffers of the
+    // printer), those give their space back; the rest waits for the reset
+    if ((char *)p == block->data + block->last && block->used > block->last) {
+        arena->bytes -= block->used - block->last;
+        block->used = block->last;
+    }
+}
+
+void initJsonArena(struct JsonArena *arena) {
+    arena->blocks = NULL;
+    arena->allocations = 0;
+    arena->bytes = 0;
+}
+
+void beginJsonArena(struct JsonArena *arena) {
+    // The hooks are only in place while an arena is in use, the rest of the
+    // time cJSON keeps malloc and the realloc path of its printer
+    cJSON_Hooks hooks = {arenaAllocate, arenaDeallocate};
+    cJSON_InitHooks(&hooks);
+    currentArena = arena;
+}
+
+void endJsonArena() {
+    currentArena = NULL;
+    cJSON_InitHooks(NULL);
+}
+
+void resetJsonArena(struct JsonArena *arena) {
+    // Keep only the newest block, the largest one, so a request like the
+    // last fits without allocating
+    struct ArenaBlock *block = arena->blocks;
+    if (!block)
+        return;
+    while (block->next) {
+        struct ArenaBlock *next = block->next->next;
+        free(block->next);
+        block->next = next;
+    }
+    block->used = 0;
+    block->last = 0;
+    arena->bytes = 0;
+}
+
+void freeJsonArena(struct JsonArena *arena) {
+    resetJsonArena(arena);
+    free(arena->blocks);
+    arena->blocks = NULL;
+}
@@ -1,64 +1,162 @@
-#include "cJSON.h"
 #include "jsonHandling.h"
+#include "cJSON.h"
+#include "requestWriter.h"
+#include "responseScanner.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 char *create_gemini_json_payload(const char *prompt_text) {
-    cJSON *root = cJSON_CreateObject();
-    cJSON *contents_array = cJSON_AddArrayToObject(root, "contents");
-    cJSON *content_item = cJSON_CreateObject();
-    cJSON_AddItemToArray(contents_array, content_item);
-    cJSON *parts_array = cJSON_AddArrayToObject(content_item, "parts");
-    cJSON *part_item = cJSON_CreateObject();
-    cJSON_AddItemToArray(parts_array, part_item);
-    cJSON_AddStringToObject(part_item, "text", prompt_text);
-    // printJSON(root);
-    char *json_string = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
+    static const char prefix[] = "{\"contents\":[{\"parts\":[{\"text\":\"";
+    static const char suffix[] = "\"}]}]}";
+
+    // Measure first so the prompt is escaped straight into its final buffer
+    size_t prompt_length = strlen(prompt_text);
+    size_t total = sizeof(prefix) - 1 +
+                   cJSON_EscapedLength(prompt_text, prompt_length) +
+                   sizeof(suffix) - 1;
+    char *json_string = malloc(total + 1);
+    if (!json_string)
+        return NULL;
 
+    char *out = writeLiteral(json_string, prefix, sizeof(prefix) - 1);
+    out = cJSON_WriteEscaped(out, prompt_text, prompt_length);
+    out = writeLiteral(out, suffix, sizeof(suffix) - 1);
+    *out = '\0';
     return json_string;
 }
 
-const char *preparePostData(char *userPrompt, char *extraContext,
-                            char *history) {
-    int fullPromptLength =
-        strlen(userPrompt) + strlen(extraContext) + strlen(history) + 1;
-    char *fullPrompt = malloc(fullPromptLength);
+const char *preparePostData(const struct ChatHistory *history,
+                            const char *systemInstruction) {
+    static const char summaryLabel[] = "Summary of the earlier conversation:";
+    static const char partPrefix[] = "{\"text\":\"";
+    static const char partSuffix[] = "\"}";
+    static const char instructionPrefix[] =
+        "\"systemInstruction\":{\"parts\":[";
+    static const char contentsPrefix[] = "\"contents\":[";
+    size_t part_overhead = sizeof(partPrefix) - 1 + sizeof(partSuffix) - 1;
 
-    strcpy(fullPrompt, userPrompt);
-    strcat(fullPrompt, extraContext);
-    strcat(fullPrompt, history);
-    const char *post_data = create_gemini_json_payload(fullPrompt);
-    free(fullPrompt);
-    return post_data;
-}
+    size_t instruction_length = systemInstruction ? strlen(systemInstruction) : 0;
+    size_t summary_length = history->summary ? strlen(history->summary) : 0;
+    int has_instruction = systemInstruction || history->summary;
 
-char *parse_gemini_response(const char *response_json) {
-    char *extracted_text = NULL;
-    cJSON *root = cJSON_Parse(response_json);
-    if (root == NULL) {
-        const char *error_ptr = cJSON_GetErrorPtr();
-        if (error_ptr != NULL) {
-            fprintf(stderr, "Error before: %s\n", error_ptr);
-        }
+    // Measure the exact size of the body. Turns were escaped when they were
+    // added, so only the instruction and summary are scanned here.
+    size_t total = strlen("{") + sizeof(contentsPrefix) - 1 + strlen("]}");
+    if (has_instruction) {
+        total += sizeof(instructionPrefix) - 1 + strlen("]},");
+        if (systemInstruction)
+            total += part_overhead +
+                     cJSON_EscapedLength(systemInstruction, instruction_length);
+        if (history->summary)
+            total += (systemInstruction ? 1 : 0) + part_overhead +
+                     sizeof(summaryLabel) - 1 + 1 + part_overhead +
+                     cJSON_EscapedLength(history->summary, summary_length);
+    }
+    for (int i = 0; i < history->count; i++)
+        total += history->turns[i].entryLength + (i > 0 ? 1 : 0);
+
+    char *post_data = malloc(total + 1);
+    if (!post_data)
         return NULL;
+
+    // Formatting rules go in systemInstruction so they are not repeated as
+    // part of the conversation, along with the summary of compacted turns
+    char *out = writeLiteral(post_data, "{", sizeof("{") - 1);
+    if (has_instruction) {
+        out =
+            writeLiteral(out, instructionPrefix, sizeof(instructionPrefix) - 1);
+        if (systemInstruction) {
+            out = writeLiteral(out, partPrefix, sizeof(partPrefix) - 1);
+            out = cJSON_WriteEscaped(out, systemInstruction,
+                                     instruction_length);
+            out = writeLiteral(out, partSuffix, sizeof(partSuffix) - 1);
+        }
+        if (history->summary) {
+            if (systemInstruction)
+                out = writeLiteral(out, ",", sizeof(",") - 1);
+            out = writeLiteral(out, partPrefix, sizeof(partPrefix) - 1);
+            out = writeLiteral(out, summaryLabel, sizeof(summaryLabel) - 1);
+            out = writeLiteral(out, partSuffix, sizeof(partSuffix) - 1);
+            out = writeLiteral(out, ",", sizeof(",") - 1);
+            out = writeLiteral(out, partPrefix, sizeof(partPrefix) - 1);
+            out = cJSON_WriteEscaped(out, history->summary, summary_length);
+            out = writeLiteral(out, partSuffix, sizeof(partSuffix) - 1);
+        }
+        out = writeLiteral(out, "]},", sizeof("]},") - 1);
     }
 
-    // Navigate to: candidates -> [0] -> content -> parts -> [0] -> text
-    cJSON *candidates = cJSON_GetObjectItemCaseSensitive(root, "candidates");
-    cJSON *candidate = cJSON_GetArrayItem(candidates, 0);
+    // Every turn becomes its own entry of contents, the last one is the
+    // prompt being asked now
+    out = writeLiteral(out, contentsPrefix, sizeof(contentsPrefix) - 1);
+    for (int i = 0; i < history->count; i++) {
+        if (i > 0)
+            out = writeLiteral(out, ",", sizeof(",") - 1);
+        memcpy(out, history->turns[i].entry, history->turns[i].entryLength);
+        out += history->turns[i].entryLength;
+    }
+    out = writeLiteral(out, "]}", sizeof("]}") - 1);
+    *out = '\0';
+    return post_data;
+}
 
-    cJSON *content = cJSON_GetObjectItemCaseSensitive(candidate, "content");
+void initAnswerInfo(struct AnswerInfo *info) {
+    info->finishReason[0] = '\0';
+    info->promptTokens = -1;
+    info->candidatesTokens = -1;
+    info->totalTokens = -1;
+}
 
-    cJSON *parts = cJSON_GetObjectItemCaseSensitive(content, "parts");
+// helper to hand over the text of the first candidate, reporting error
+// bodies instead of returning text. Fields the response did not report are
+// left alone in info, a stream only reports finishReason at the end and
+// its usage may come with any chunk.
+static char *take_first_text(struct GeminiResponse *response,
+                             struct AnswerInfo *info) {
+    char *extracted_text = NULL;
+    if (info && response->candidateCount > 0 &&
+        response->candidates[0].finishReason[0])
+        memcpy(info->finishReason, response->candidates[0].finishReason,
+               sizeof(info->finishReason));
+    if (info && response->totalTokens >= 0) {
+        info->promptTokens = response->promptTokens;
+        info->candidatesTokens = response->candidatesTokens;
+        info->totalTokens = response->totalTokens;
+    }
+    if (response->errorMessage) {
+        fprintf(stderr, "API error %ld: %s\n", response->errorCode,
+                response->errorMessage);
+    } else if (response->candidateCount > 0) {
+        extracted_text = response->candidates[0].text;
+        response->candidates[0].text = NULL;
+    }
+    freeGeminiResponse(response);
+    return extracted_text;
+}
 
-    cJSON *part = cJSON_GetArrayItem(parts, 0);
+char *parse_gemini_response(const char *response_json,
+                            struct AnswerInfo *info) {
+    struct GeminiResponse response;
+    if (!response_json)
+        return NULL;
 
-    cJSON *text_obj = cJSON_GetObjectItemCaseSensitive(part, "text");
+    // Walk straight to candidates[].content.parts[].text, everything else in
+    // the response (safetyRatings, citations, ...) is skipped unparsed
+    if (!scanGeminiResponse(response_json, strlen(response_json), &response)) {
+        fprintf(stderr, "Error: malformed response from the server\n");
+        freeGeminiResponse(&response);
+        return NULL;
+    }
+    return take_first_text(&response, info);
+}
 
-    extracted_text = strdup(text_obj->valuestring);
+char *parse_gemini_chunk(const char *chunk_json, struct AnswerInfo *info) {
+    struct GeminiResponse response;
+    if (!chunk_json)
+        return NULL;
 
-    cJSON_Delete(root);  // Free the parsed JSON object
-    return extracted_text;
-}
\ No newline at end of file
+    // A chunk may carry several parts, or none at all (e.g. the final event
+    // that only reports finishReason), the scanner joins whatever is present
+    scanGeminiResponse(chunk_json, strlen(chunk_json), &response);
+    return take_first_text(&response, info);
+}
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>  // For isatty()
 #include "../includes/myio.h"
 
 void sleep_ms(long milliseconds) {
@@ -13,20 +14,61 @@ void sleep_ms(long milliseconds) {
     nanosleep(&req, NULL);
 }
 
-void displayStringWithDelay(char *str) {
-    char ch;
-    int len = strlen(str);
-    int lineCount = 0;
-    for (int i = 0; i < len; i++) {
-        ch = str[i];
-        printf("%c", ch);
-        if (i % 100 == 0)
-            sleep_ms(50);
-        else if (i % 501 == 0)
-            sleep_ms(150);
+// helper to read a monotonic clock in milliseconds
+static long long now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+void initRenderer(struct Renderer *renderer, int typewriter) {
+    // Animation only makes sense for a person watching a terminal, pipes and
+    // files get the text as fast as possible
+    renderer->typewriter = typewriter && isatty(STDOUT_FILENO);
+    renderer->animatedMs = 0;
+    renderer->lastFlushMs = 0;
+    renderer->pending = 0;
+}
+
+void flushRender(struct Renderer *renderer) {
+    if (renderer->pending > 0)
+        fflush(stdout);
+    renderer->pending = 0;
+    renderer->lastFlushMs = now_ms();
+}
+
+void renderText(struct Renderer *renderer, const char *text, size_t length) {
+    size_t offset = 0;
+
+    // Reveal a few characters per frame while the animation budget lasts
+    while (renderer->typewriter && offset < length &&
+           renderer->animatedMs < TYPEWRITER_BUDGET_MS) {
+        size_t slice = length - offset;
+        if (slice > TYPEWRITER_CHARS_PER_FRAME)
+            slice = TYPEWRITER_CHARS_PER_FRAME;
+        fwrite(text + offset, 1, slice, stdout);
+        fflush(stdout);
+        offset += slice;
+        sleep_ms(RENDER_FRAME_MS);
+        renderer->animatedMs += RENDER_FRAME_MS;
+    }
+
+    // Whatever is left goes out as one chunk, flushed at the frame rate
+    if (offset < length) {
+        fwrite(text + offset, 1, length - offset, stdout);
+        renderer->pending += length - offset;
+        if (now_ms() - renderer->lastFlushMs >= RENDER_FRAME_MS)
+            flushRender(renderer);
     }
 }
 
+void displayStringWithDelay(char *str) {
+    struct Renderer renderer;
+    initRenderer(&renderer, 1);
+    renderText(&renderer, str, strlen(str));
+    flushRender(&renderer);
+}
+
 char *readString() {
     char *prompt = NULL;
     char ch;
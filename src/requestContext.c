@@ -0,0 +1,335 @@
+#include "requestContext.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "connectionCache.h"
+
+void initApiConfig(struct ApiConfig *config, const char *api_key) {
+    const char *base = getenv("ASKAI_ENDPOINT");
+    const char *model = getenv("ASKAI_MODEL");
+    config->apiKey = api_key;
+    config->baseUrl = base && base[0] ? base : DEFAULT_API_BASE;
+    config->model = model && model[0] ? model : DEFAULT_MODEL;
+    config->connections = NULL;
+}
+
+int buildApiUrl(const struct ApiConfig *config, const char *method, char *url,
+                size_t size) {
+    // A trailing slash on the base url is tolerated
+    size_t base_len = strlen(config->baseUrl);
+    if (base_len > 0 && config->baseUrl[base_len - 1] == '/')
+        base_len--;
+
+    // Streaming asks for server-sent events, the key goes in the query
+    const char *query = strcmp(method, "streamGenerateContent") == 0
+                            ? "?alt=sse&key="
+                            : "?key=";
+    int url_len = snprintf(url, size, "%.*s/models/%s:%s%s%s", (int)base_len,
+                           config->baseUrl, config->model, method, query,
+                           config->apiKey);
+    return url_len >= 0 && (size_t)url_len < size;
+}
+
+void configureApiHandle(CURL *curl, struct curl_slist *headers,
+                        const char *url) {
+    // Options that stay the same for every request are set only once here
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    // Keep the connection alive between turns, the user may take a while to
+    // type the next prompt
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+
+    // Negotiate HTTP/2 over TLS when libcurl and the server support it
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+}
+
+int initRequestContext(struct RequestContext *ctx,
+                       const struct ApiConfig *config, int streaming) {
+    memset(ctx, 0, sizeof(*ctx));
+
+    // Construct the full URL with the API key
+    if (!buildApiUrl(config,
+                     streaming ? "streamGenerateContent" : "generateContent",
+                     ctx->url, sizeof(ctx->url))) {
+        fprintf(stderr, "Error: API URL too long.\n");
+        return 0;
+    }
+
+    ctx->curl = curl_easy_init();
+    ctx->multi = curl_multi_init();
+    if (!ctx->curl || !ctx->multi) {
+        cleanupRequestContext(ctx);
+        return 0;
+    }
+
+    ctx->headers =
+        curl_slist_append(ctx->headers, "Content-Type: application/json");
+    configureApiHandle(ctx->curl, ctx->headers, ctx->url);
+    ctx->connections = config->connections;
+    applyConnectionCache(ctx->connections, ctx->curl);
+
+    // Warm-up requests only need the host, they never carry the key
+    snprintf(ctx->warmUrl, sizeof(ctx->warmUrl), "%s", config->baseUrl);
+    return 1;
+}
+
+// A warm-up that takes longer than this is abandoned
+#define WARMUP_TIMEOUT_S 10L
+// Percentile of the first-byte latency after which a hedge is sent
+#define HEDGE_PERCENTILE 95.0
+
+// One of the (at most two) transfers racing to answer the same request
+struct Leg {
+    struct Race *race;
+    CURL *curl;
+    atomic_int *cancel;  // aborts the leg once set
+    double startedAfterMs;  // when the leg started, after the first one
+    int done;
+    CURLcode result;
+};
+
+// The response of a request goes to the callback from whichever leg sends
+// the first bytes; the other leg is dropped
+struct Race {
+    ResponseCallback callback;
+    void *userp;
+    struct Leg *winner;
+    int (*abortCheck)(void *arg);  // see RequestContext, may be NULL
+    void *abortArg;
+};
+
+// The body of a warm-up response is of no interest
+static size_t discardBody(void *contents, size_t size, size_t nmemb,
+                          void *userp) {
+    (void)contents;
+    (void)userp;
+    return size * nmemb;
+}
+
+// Write callback of every leg, the first one to answer claims the response.
+// All legs run on the thread driving the multi handle, so no lock is needed.
+static size_t legWrite(void *contents, size_t size, size_t nmemb, void *p) {
+    struct Leg *leg = p;
+    struct Race *race = leg->race;
+    if (!race->winner)
+        race->winner = leg;
+    if (race->winner != leg)
+        return 0;  // the other leg answered first, abort this one
+    return race->callback(contents, size, nmemb, race->userp);
+}
+
+// Progress callback of every leg, returning non-zero aborts the transfer
+static int legProgress(void *clientp, curl_off_t dltotal, curl_off_t dlnow,
+                       curl_off_t ultotal, curl_off_t ulnow) {
+    (void)dltotal;
+    (void)dlnow;
+    (void)ultotal;
+    (void)ulnow;
+    struct Leg *leg = clientp;
+    if (atomic_load(leg->cancel))
+        return 1;
+    return leg->race->abortCheck && leg->race->abortCheck(leg->race->abortArg);
+}
+
+static void startLeg(CURLM *multi, struct Leg *leg, struct Race *race,
+                     CURL *curl, atomic_int *cancel) {
+    leg->race = race;
+    leg->curl = curl;
+    leg->cancel = cancel;
+    leg->startedAfterMs = 0;
+    leg->done = 0;
+    leg->result = CURLE_OK;
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, legWrite);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, leg);
+    // Checked by libcurl while waiting for and receiving the answer, so a
+    // cancelled generation stops costing tokens and bandwidth right away
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, legProgress);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, leg);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, leg);
+    curl_multi_add_handle(multi, curl);
+}
+
+// helper to get the second handle of the session, set up like the first one
+static CURL *hedgeHandle(struct RequestContext *ctx) {
+    if (!ctx->hedge) {
+        ctx->hedge = curl_easy_init();
+        if (ctx->hedge) {
+            configureApiHandle(ctx->hedge, ctx->headers, ctx->url);
+            applyConnectionCache(ctx->connections, ctx->hedge);
+        }
+    }
+    return ctx->hedge;
+}
+
+// Drives the legs on the session's multi handle until one of them settles
+// the request: the leg that answered once it completes, or the last leg
+// standing if none answered. With hedgeAfterMs > 0 and no answer by then, a
+// copy of the request is started on the hedge handle.
+static struct Leg *runRace(struct RequestContext *ctx, struct Race *race,
+                           struct Leg legs[2], const char *post_data,
+                           long hedgeAfterMs) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    double start = ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+    int active = 1;
+    struct Leg *settled = NULL;
+
+    while (!settled) {
+        int running;
+        curl_multi_perform(ctx->multi, &running);
+
+        CURLMsg *msg;
+        int queued;
+        while ((msg = curl_multi_info_read(ctx->multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+            struct Leg *leg;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&leg);
+            leg->done = 1;
+            leg->result = msg->data.result;
+            curl_multi_remove_handle(ctx->multi, leg->curl);
+            active--;
+            if (race->winner == leg || (!race->winner && active == 0))
+                settled = leg;
+        }
+        if (settled)
+            break;
+
+        long timeout = 1000;
+        if (hedgeAfterMs > 0 && !legs[1].curl && !race->winner) {
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            double waited = ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6 - start;
+            CURL *hedge = waited >= hedgeAfterMs ? hedgeHandle(ctx) : NULL;
+            if (hedge) {
+                curl_easy_setopt(hedge, CURLOPT_POSTFIELDS, post_data);
+                curl_easy_setopt(hedge, CURLOPT_POSTFIELDSIZE,
+                                 (long)strlen(post_data));
+                startLeg(ctx->multi, &legs[1], race, hedge, &ctx->cancelled);
+                legs[1].startedAfterMs = waited;
+                active++;
+                ctx->hedged = 1;
+                continue;
+            }
+            if (hedgeAfterMs - waited < timeout)
+                timeout = (long)(hedgeAfterMs - waited) + 1;
+        }
+        curl_multi_poll(ctx->multi, NULL, 0, (int)timeout, NULL);
+    }
+
+    // Removing a leg that is still running aborts it on the spot
+    for (int i = 0; i < 2; i++) {
+        if (legs[i].curl && !legs[i].done)
+            curl_multi_remove_handle(ctx->multi, legs[i].curl);
+    }
+    return settled;
+}
+
+// Worker of startWarmup, any status code will do as long as the connection
+// ends up in the pool of the session's multi handle
+static void *warmupThread(void *arg) {
+    struct RequestContext *ctx = arg;
+    curl_easy_setopt(ctx->curl, CURLOPT_URL, ctx->warmUrl);
+    curl_easy_setopt(ctx->curl, CURLOPT_NOBODY, 1L);
+    // An unreachable endpoint must not keep the next request or the exit
+    // waiting longer than a real request would
+    curl_easy_setopt(ctx->curl, CURLOPT_TIMEOUT, WARMUP_TIMEOUT_S);
+
+    struct Race race = {discardBody, NULL, NULL, NULL, NULL};
+    struct Leg legs[2];
+    memset(legs, 0, sizeof(legs));
+    startLeg(ctx->multi, &legs[0], &race, ctx->curl, &ctx->cancelWarmup);
+    struct Leg *settled = runRace(ctx, &race, legs, NULL, 0);
+    if (settled->result == CURLE_OK)
+        rememberConnection(ctx->connections, ctx->curl);
+    return NULL;
+}
+
+void startWarmup(struct RequestContext *ctx) {
+    if (!ctx->curl || ctx->warming)
+        return;
+    atomic_store(&ctx->cancelWarmup, 0);
+    ctx->warming = pthread_create(&ctx->warmer, NULL, warmupThread, ctx) == 0;
+}
+
+void finishWarmup(struct RequestContext *ctx) {
+    if (!ctx->warming)
+        return;
+    pthread_join(ctx->warmer, NULL);
+    ctx->warming = 0;
+
+    // Back to the POST request the session is configured for
+    curl_easy_setopt(ctx->curl, CURLOPT_NOBODY, 0L);
+    curl_easy_setopt(ctx->curl, CURLOPT_URL, ctx->url);
+    curl_easy_setopt(ctx->curl, CURLOPT_TIMEOUT, 0L);
+}
+
+void cancelRequest(struct RequestContext *ctx) {
+    atomic_store(&ctx->cancelled, 1);
+}
+
+void resetCancel(struct RequestContext *ctx) {
+    atomic_store(&ctx->cancelled, 0);
+}
+
+CURLcode performRequest(struct RequestContext *ctx, const char *post_data,
+                        ResponseCallback callback, void *userp) {
+    finishWarmup(ctx);
+    ctx->winner = ctx->curl;
+    ctx->hedged = 0;
+    if (atomic_load(&ctx->cancelled))
+        return CURLE_ABORTED_BY_CALLBACK;
+
+    // A hedge goes out once the first byte is later than it usually is
+    long hedgeAfterMs = ctx->hedgeAfterMs;
+    if (hedgeAfterMs == HEDGE_AUTO) {
+        hedgeAfterMs = (long)latencyPercentile(&ctx->latency, HEDGE_PERCENTILE);
+        if (hedgeAfterMs <= 0)
+            hedgeAfterMs = HEDGE_DEFAULT_MS;
+    }
+
+    curl_easy_setopt(ctx->curl, CURLOPT_POSTFIELDS, post_data);
+    curl_easy_setopt(ctx->curl, CURLOPT_POSTFIELDSIZE, (long)strlen(post_data));
+    struct Race race = {callback, userp, NULL, ctx->abortCheck, ctx->abortArg};
+    struct Leg legs[2];
+    memset(legs, 0, sizeof(legs));
+    startLeg(ctx->multi, &legs[0], &race, ctx->curl, &ctx->cancelled);
+
+    // The multi handle keeps its connection pool, so this reuses the
+    // connection opened by the previous turn whenever the server kept it open
+    struct Leg *settled = runRace(ctx, &race, legs, post_data, hedgeAfterMs);
+    ctx->winner = settled->curl;
+    if (settled->result == CURLE_OK) {
+        rememberConnection(ctx->connections, settled->curl);
+        curl_off_t ttfb = 0;
+        curl_easy_getinfo(settled->curl, CURLINFO_STARTTRANSFER_TIME_T, &ttfb);
+        // A hedge's own timer leaves out the wait before it was sent, the
+        // latency the user saw started with the first leg
+        recordLatency(&ctx->latency, settled->startedAfterMs + ttfb / 1000.0);
+    }
+    return settled->result;
+}
+
+void cleanupRequestContext(struct RequestContext *ctx) {
+    atomic_store(&ctx->cancelWarmup, 1);
+    finishWarmup(ctx);
+    if (ctx->curl)
+        curl_easy_cleanup(ctx->curl);
+    if (ctx->hedge)
+        curl_easy_cleanup(ctx->hedge);
+    if (ctx->multi)
+        curl_multi_cleanup(ctx->multi);
+    if (ctx->headers)
+        curl_slist_free_all(ctx->headers);
+    ctx->headers = NULL;
+    ctx->curl = NULL;
+    ctx->hedge = NULL;
+    ctx->multi = NULL;
+}
@@ -0,0 +1,61 @@
+#include "requestWriter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cJSON.h"
+
+int appendJsonString(struct StringBuffer *buf, const char *text,
+                     size_t length) {
+    size_t escaped = cJSON_EscapedLength(text, length);
+    if (!reserveBuffer(buf, escaped + 2))
+        return 0;
+
+    char *out = buf->data + buf->length;
+    *out++ = '\"';
+    out = cJSON_WriteEscaped(out, text, length);
+    *out++ = '\"';
+    buf->length = out - buf->data;
+    buf->data[buf->length] = '\0';
+    return 1;
+}
+
+char *writeLiteral(char *out, const char *literal, size_t length) {
+    memcpy(out, literal, length);
+    return out + length;
+}
+
+char *renderContentEntry(const char *role, const char *text, size_t length,
+                         size_t *entryLength) {
+    static const char rolePrefix[] = "{\"role\":\"";
+    static const char partsPrefix[] = "\",\"parts\":[{\"text\":\"";
+    static const char noRolePrefix[] = "{\"parts\":[{\"text\":\"";
+    static const char suffix[] = "\"}]}";
+
+    size_t roleLength = role ? strlen(role) : 0;
+    size_t escapedRole = role ? cJSON_EscapedLength(role, roleLength) : 0;
+    size_t total = cJSON_EscapedLength(text, length) + sizeof(suffix) - 1;
+    if (role)
+        total += sizeof(rolePrefix) - 1 + escapedRole + sizeof(partsPrefix) - 1;
+    else
+        total += sizeof(noRolePrefix) - 1;
+
+    char *entry = malloc(total + 1);
+    if (!entry)
+        return NULL;
+
+    char *out = entry;
+    if (role) {
+        out = writeLiteral(out, rolePrefix, sizeof(rolePrefix) - 1);
+        out = cJSON_WriteEscaped(out, role, roleLength);
+        out = writeLiteral(out, partsPrefix, sizeof(partsPrefix) - 1);
+    } else {
+        out = writeLiteral(out, noRolePrefix, sizeof(noRolePrefix) - 1);
+    }
+    out = cJSON_WriteEscaped(out, text, length);
+    out = writeLiteral(out, suffix, sizeof(suffix) - 1);
+    *out = '\0';
+
+    *entryLength = total;
+    return entry;
+}
@@ -0,0 +1,392 @@
+#include "responseCache.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>  // For flock()
+#include <sys/stat.h>  // For mkdir()
+#include <time.h>
+#include <unistd.h>  // For unlink() and getpid()
+
+// First bytes of the index file, bumped whenever the record layout changes
+static const char indexMagic[8] = "ASKCIDX1";
+
+// Temporary files this old were left by a process that died while writing
+#define STALE_TEMP_S (10 * 60)
+
+// Two independent 64-bit hashes fed with the same bytes: FNV-1a and a
+// multiply-xorshift mix. Together they make a 128-bit key so distinct
+// requests never realistically share a file.
+struct KeyHasher {
+    uint64_t fnv;
+    uint64_t mix;
+};
+
+static void hashBytes(struct KeyHasher *h, const void *data, size_t length) {
+    const unsigned char *p = data;
+    uint64_t fnv = h->fnv, mix = h->mix;
+    for (size_t i = 0; i < length; i++) {
+        fnv = (fnv ^ p[i]) * 0x100000001b3ULL;
+        mix = (mix ^ p[i]) * 0x9e3779b97f4a7c15ULL;
+        mix ^= mix >> 29;
+    }
+    h->fnv = fnv;
+    h->mix = mix;
+}
+
+// The key covers where the request goes as well as what it says, so answers
+// from a mock server or another model are never mixed up
+static void requestKey(const struct ResponseCache *cache, const char *body,
+                       size_t length, uint64_t key[2]) {
+    struct KeyHasher h = {0xcbf29ce484222325ULL, 0x243f6a8885a308d3ULL};
+    hashBytes(&h, cache->config->baseUrl, strlen(cache->config->baseUrl) + 1);
+    hashBytes(&h, cache->config->model, strlen(cache->config->model) + 1);
+    hashBytes(&h, body, length);
+    key[0] = h.fnv;
+    key[1] = h.mix;
+}
+
+static int compareKeys(const uint64_t a[2], const uint64_t b[2]) {
+    if (a[0] != b[0])
+        return a[0] < b[0] ? -1 : 1;
+    if (a[1] != b[1])
+        return a[1] < b[1] ? -1 : 1;
+    return 0;
+}
+
+static int compareRecords(const void *a, const void *b) {
+    return compareKeys(((const struct CacheRecord *)a)->key,
+                       ((const struct CacheRecord *)b)->key);
+}
+
+// helper to find the record of a key, or where it would be inserted
+static size_t findRecord(const struct ResponseCache *cache,
+                         const uint64_t key[2], int *found) {
+    size_t low = 0, high = cache->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int cmp = compareKeys(cache->records[mid].key, key);
+        if (cmp == 0) {
+            *found = 1;
+            return mid;
+        }
+        if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    *found = 0;
+    return low;
+}
+
+static void entryPath(const struct ResponseCache *cache,
+                      const uint64_t key[2], char *path, size_t size) {
+    snprintf(path, size, "%s/%016llx%016llx", cache->dir,
+             (unsigned long long)key[0], (unsigned long long)key[1]);
+}
+
+// helper to remove the record at index together with its answer file
+static void dropRecord(struct ResponseCache *cache, size_t index) {
+    char path[1100];
+    entryPath(cache, cache->records[index].key, path, sizeof(path));
+    unlink(path);
+    cache->totalBytes -= cache->records[index].size;
+    memmove(&cache->records[index], &cache->records[index + 1],
+            (cache->count - index - 1) * sizeof(struct CacheRecord));
+    cache->count--;
+    cache->dirty = 1;
+}
+
+// helper to write a whole file under a temporary name and move it in place,
+// so a reader never sees half of it
+static int writeFileAtomic(const char *path, const void *data1, size_t len1,
+                           const void *data2, size_t len2) {
+    char tmp[1200];
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+    FILE *file = fopen(tmp, "wb");
+    if (!file)
+        return 0;
+    int ok = fwrite(data1, 1, len1, file) == len1 &&
+             (len2 == 0 || fwrite(data2, 1, len2, file) == len2);
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return 0;
+    }
+    return 1;
+}
+
+// helper to load the index file, a missing or foreign index is an empty cache
+static void loadIndex(struct ResponseCache *cache) {
+    char path[1100];
+    snprintf(path, sizeof(path), "%s/index", cache->dir);
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return;
+
+    char magic[8];
+    struct stat st;
+    if (fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+        memcmp(magic, indexMagic, sizeof(magic)) == 0 &&
+        fstat(fileno(file), &st) == 0) {
+        size_t count = (st.st_size - sizeof(magic)) / sizeof(struct CacheRecord);
+        cache->records = malloc((count ? count : 1) * sizeof(struct CacheRecord));
+        if (cache->records) {
+            cache->capacity = count ? count : 1;
+            cache->count =
+                fread(cache->records, sizeof(struct CacheRecord), count, file);
+        }
+    }
+    fclose(file);
+
+    // The index is written sorted, sorting again only guards against a file
+    // written by hand or by an older version
+    qsort(cache->records, cache->count, sizeof(struct CacheRecord),
+          compareRecords);
+    for (size_t i = 0; i < cache->count; i++)
+        cache->totalBytes += cache->records[i].size;
+}
+
+// helper to read the key out of an answer file name, 32 hex digits
+static int parseEntryName(const char *name, uint64_t key[2]) {
+    if (strlen(name) != 32 || strspn(name, "0123456789abcdef") != 32)
+        return 0;
+    char half[17];
+    for (int i = 0; i < 2; i++) {
+        memcpy(half, name + i * 16, 16);
+        half[16] = '\0';
+        key[i] = strtoull(half, NULL, 16);
+    }
+    return 1;
+}
+
+// helper to rebuild the records from the answer files in the directory, so
+// answers stored by other processes, including one killed before it wrote
+// the index, are counted against the size limit and evicted like any other.
+// Returns 0 and keeps the records as they are if the directory can't be read.
+static int scanDirectory(struct ResponseCache *cache) {
+    DIR *dir = opendir(cache->dir);
+    if (!dir)
+        return 0;
+
+    struct CacheRecord *records = NULL;
+    size_t count = 0, capacity = 0;
+    uint64_t totalBytes = 0;
+    int64_t now = time(NULL);
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char path[1400];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", cache->dir, entry->d_name);
+        uint64_t key[2];
+        if (!parseEntryName(entry->d_name, key)) {
+            size_t length = strlen(entry->d_name);
+            if (length > 4 && strcmp(entry->d_name + length - 4, ".tmp") == 0 &&
+                stat(path, &st) == 0 && now - st.st_mtime > STALE_TEMP_S)
+                unlink(path);
+            continue;
+        }
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) ||
+            (uint64_t)st.st_size > UINT32_MAX)
+            continue;
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            struct CacheRecord *grown =
+                realloc(records, capacity * sizeof(struct CacheRecord));
+            if (!grown) {
+                free(records);
+                closedir(dir);
+                return 0;
+            }
+            records = grown;
+        }
+        // An answer file is written once, so its modification time is when
+        // it was stored
+        struct CacheRecord *record = &records[count++];
+        memset(record, 0, sizeof(*record));
+        record->key[0] = key[0];
+        record->key[1] = key[1];
+        record->stored = st.st_mtime;
+        record->size = (uint32_t)st.st_size;
+        totalBytes += record->size;
+    }
+    closedir(dir);
+
+    qsort(records, count, sizeof(struct CacheRecord), compareRecords);
+    free(cache->records);
+    cache->records = records;
+    cache->count = count;
+    cache->capacity = capacity;
+    cache->totalBytes = totalBytes;
+    return 1;
+}
+
+// helper to evict expired entries, then the oldest ones until the answers
+// fit the size limit
+static void evictRecords(struct ResponseCache *cache) {
+    int64_t now = time(NULL);
+    for (size_t i = cache->count; i-- > 0;) {
+        if (now - cache->records[i].stored > cache->ttl)
+            dropRecord(cache, i);
+    }
+    while (cache->totalBytes > cache->maxBytes && cache->count > 0) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < cache->count; i++) {
+            if (cache->records[i].stored < cache->records[oldest].stored)
+                oldest = i;
+        }
+        dropRecord(cache, oldest);
+    }
+}
+
+int openResponseCache(struct ResponseCache *cache,
+                      const struct ApiConfig *config, long ttl,
+                      uint64_t maxBytes) {
+    memset(cache, 0, sizeof(*cache));
+    cache->config = config;
+    cache->ttl = ttl;
+    cache->maxBytes = maxBytes;
+
+    // The cache lives next to the config file written by getApiKey
+    const char *home_dir = getenv("HOME");
+    char base[1024];
+    if (!home_dir ||
+        snprintf(base, sizeof(base), "%s/.askai-cli", home_dir) >=
+            (int)sizeof(base) ||
+        snprintf(cache->dir, sizeof(cache->dir), "%s/cache", base) >=
+            (int)sizeof(cache->dir)) {
+        fprintf(stderr, "Error: Cache directory path too long.\n");
+        return 0;
+    }
+    mkdir(base, 0700);  // ignore errors if they already exist
+    if (mkdir(cache->dir, 0700) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create cache directory %s\n", cache->dir);
+        return 0;
+    }
+
+    loadIndex(cache);
+    cache->enabled = 1;
+    return 1;
+}
+
+char *cacheLookup(struct ResponseCache *cache, const char *body,
+                  size_t length) {
+    if (!cache || !cache->enabled)
+        return NULL;
+    uint64_t key[2];
+    requestKey(cache, body, length, key);
+    int found;
+    size_t index = findRecord(cache, key, &found);
+    if (!found)
+        return NULL;
+
+    struct CacheRecord *record = &cache->records[index];
+    if (time(NULL) - record->stored > cache->ttl) {
+        dropRecord(cache, index);
+        return NULL;
+    }
+
+    char path[1100];
+    entryPath(cache, key, path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        dropRecord(cache, index);
+        return NULL;
+    }
+    char *text = malloc(record->size + 1);
+    size_t n = text ? fread(text, 1, record->size, file) : 0;
+    fclose(file);
+    // A short read means the file was truncated or replaced, forget it
+    if (!text || n != record->size) {
+        free(text);
+        dropRecord(cache, index);
+        return NULL;
+    }
+    text[n] = '\0';
+    return text;
+}
+
+void cacheStore(struct ResponseCache *cache, const char *body, size_t length,
+                const char *text, size_t textLength, const char *finishReason) {
+    if (!cache || !cache->enabled || textLength > cache->maxBytes ||
+        textLength > UINT32_MAX)
+        return;
+    // Replaying a truncated answer would pass it off as complete
+    if (!finishReason || strcmp(finishReason, "STOP") != 0)
+        return;
+    uint64_t key[2];
+    requestKey(cache, body, length, key);
+
+    char path[1100];
+    entryPath(cache, key, path, sizeof(path));
+    if (!writeFileAtomic(path, text, textLength, NULL, 0))
+        return;
+
+    int found;
+    size_t index = findRecord(cache, key, &found);
+    if (found) {
+        cache->totalBytes -= cache->records[index].size;
+    } else {
+        if (cache->count == cache->capacity) {
+            size_t capacity = cache->capacity ? cache->capacity * 2 : 64;
+            struct CacheRecord *records =
+                realloc(cache->records, capacity * sizeof(struct CacheRecord));
+            if (!records) {
+                unlink(path);
+                return;
+            }
+            cache->records = records;
+            cache->capacity = capacity;
+        }
+        memmove(&cache->records[index + 1], &cache->records[index],
+                (cache->count - index) * sizeof(struct CacheRecord));
+        cache->count++;
+    }
+
+    struct CacheRecord *record = &cache->records[index];
+    memset(record, 0, sizeof(*record));
+    record->key[0] = key[0];
+    record->key[1] = key[1];
+    record->stored = time(NULL);
+    record->size = (uint32_t)textLength;
+    cache->totalBytes += textLength;
+    cache->dirty = 1;
+}
+
+void closeResponseCache(struct ResponseCache *cache) {
+    if (!cache->enabled)
+        return;
+
+    evictRecords(cache);
+
+    if (cache->dirty) {
+        // Other askai processes may have changed the cache since the index
+        // was loaded. Under an exclusive lock the records are rebuilt from
+        // the answer files themselves and evicted again, so the index written
+        // last still covers every file.
+        char path[1100];
+        snprintf(path, sizeof(path), "%s/lock", cache->dir);
+        int lock = open(path, O_RDWR | O_CREAT, 0600);
+        if (lock >= 0)
+            flock(lock, LOCK_EX);
+        if (scanDirectory(cache))
+            evictRecords(cache);
+
+        snprintf(path, sizeof(path), "%s/index", cache->dir);
+        if (!writeFileAtomic(path, indexMagic, sizeof(indexMagic),
+                             cache->records,
+                             cache->count * sizeof(struct CacheRecord)))
+            fprintf(stderr, "Could not write the cache index %s\n", path);
+        if (lock >= 0)
+            close(lock);  // releases the lock
+    }
+
+    free(cache->records);
+    cache->records = NULL;
+    cache->count = cache->capacity = 0;
+    cache->enabled = 0;
+}
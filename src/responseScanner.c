@@ -0,0 +1,452 @@
+#include "responseScanner.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stringBuffer.h"
+
+// Deepest nesting the scanner follows before giving up, same as cJSON
+#define SCAN_NESTING_LIMIT 1000
+
+// Read position inside the response being scanned
+struct Scanner {
+    const char *p;
+    const char *end;
+};
+
+static void skipWhitespace(struct Scanner *s) {
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\n' || *s->p == '\r' ||
+                             *s->p == '\t'))
+        s->p++;
+}
+
+// helper to step over the next expected character, returns 0 if it is not
+// there
+static int expect(struct Scanner *s, char c) {
+    skipWhitespace(s);
+    if (s->p >= s->end || *s->p != c)
+        return 0;
+    s->p++;
+    return 1;
+}
+
+// Moves past a string whose opening quote was already consumed, without
+// looking at what it contains
+static int skipStringBody(struct Scanner *s) {
+    while (s->p < s->end) {
+        // Most of a string is plain bytes, let memchr find the next quote
+        const char *quote = memchr(s->p, '\"', s->end - s->p);
+        if (!quote)
+            return 0;
+
+        // The quote only ends the string if it is preceded by an even number
+        // of backslashes
+        const char *back = quote;
+        while (back > s->p && back[-1] == '\\')
+            back--;
+        s->p = quote + 1;
+        if (((quote - back) & 1) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+// Moves past any value, containers are skipped by counting brackets only
+static int skipValue(struct Scanner *s) {
+    skipWhitespace(s);
+    if (s->p >= s->end)
+        return 0;
+
+    char c = *s->p;
+    if (c == '\"') {
+        s->p++;
+        return skipStringBody(s);
+    }
+    if (c != '{' && c != '[') {
+        // Numbers, true, false and null run until the next delimiter
+        const char *start = s->p;
+        while (s->p < s->end && *s->p != ',' && *s->p != '}' && *s->p != ']' &&
+               *s->p != ' ' && *s->p != '\n' && *s->p != '\r' && *s->p != '\t')
+            s->p++;
+        return s->p > start;
+    }
+
+    int depth = 0;
+    while (s->p < s->end) {
+        c = *s->p++;
+        if (c == '\"') {
+            if (!skipStringBody(s))
+                return 0;
+        } else if (c == '{' || c == '[') {
+            if (++depth > SCAN_NESTING_LIMIT)
+                return 0;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+// Reads an object key in place. Keys we look for are plain ASCII, so the raw
+// bytes between the quotes are compared without unescaping.
+static int readKey(struct Scanner *s, const char **key, size_t *keyLength) {
+    if (!expect(s, '\"'))
+        return 0;
+    *key = s->p;
+    if (!skipStringBody(s))
+        return 0;
+    *keyLength = (s->p - 1) - *key;
+    return expect(s, ':');
+}
+
+static int keyIs(const char *key, size_t keyLength, const char *name) {
+    return strlen(name) == keyLength && memcmp(key, name, keyLength) == 0;
+}
+
+// helper to parse 4 hex digits of a \u escape
+static int parseHex4(const char *p, unsigned int *value) {
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        *value <<= 4;
+        if (c >= '0' && c <= '9')
+            *value |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            *value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            *value |= c - 'A' + 10;
+        else
+            return 0;
+    }
+    return 1;
+}
+
+// helper to encode a code point as UTF-8, returns the position after it
+static char *writeCodePoint(char *dst, unsigned int cp) {
+    if (cp < 0x80) {
+        *dst++ = (char)cp;
+    } else if (cp < 0x800) {
+        *dst++ = (char)(0xC0 | (cp >> 6));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *dst++ = (char)(0xE0 | (cp >> 12));
+        *dst++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *dst++ = (char)(0xF0 | (cp >> 18));
+        *dst++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *dst++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return dst;
+}
+
+// Unescapes the string at the read position and appends it to out, this is
+// the only place the scanner allocates
+static int readString(struct Scanner *s, struct StringBuffer *out) {
+    if (!expect(s, '\"'))
+        return 0;
+
+    // Find the closing quote first, the unescaped text is never longer than
+    // the raw one, so the buffer only needs to grow once
+    const char *p = s->p;
+    if (!skipStringBody(s))
+        return 0;
+    const char *end = s->p - 1;
+    if (!reserveBuffer(out, end - p))
+        return 0;
+    char *dst = out->data + out->length;
+
+    while (p < end) {
+        // Copy the run of plain bytes up to the next backslash in one go
+        const char *escape = memchr(p, '\\', end - p);
+        const char *run_end = escape ? escape : end;
+        memcpy(dst, p, run_end - p);
+        dst += run_end - p;
+        p = run_end;
+        if (!escape)
+            break;
+
+        // Escape sequence
+        if (end - p < 2)
+            return 0;
+        char c = p[1];
+        p += 2;
+        switch (c) {
+            case '\"':
+            case '\\':
+            case '/':
+                *dst++ = c;
+                break;
+            case 'b':
+                *dst++ = '\b';
+                break;
+            case 'f':
+                *dst++ = '\f';
+                break;
+            case 'n':
+                *dst++ = '\n';
+                break;
+            case 'r':
+                *dst++ = '\r';
+                break;
+            case 't':
+                *dst++ = '\t';
+                break;
+            case 'u': {
+                unsigned int cp;
+                if (end - p < 4 || !parseHex4(p, &cp))
+                    return 0;
+                p += 4;
+                // A high surrogate has to be followed by a low surrogate
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    unsigned int low;
+                    if (end - p < 6 || p[0] != '\\' || p[1] != 'u' ||
+                        !parseHex4(p + 2, &low) || low < 0xDC00 ||
+                        low > 0xDFFF)
+                        return 0;
+                    p += 6;
+                    cp = 0x10000 + (((cp & 0x3FF) << 10) | (low & 0x3FF));
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return 0;
+                }
+                // The escape took 6 or 12 bytes, its UTF-8 form at most 4
+                dst = writeCodePoint(dst, cp);
+                break;
+            }
+            default:
+                return 0;
+        }
+    }
+
+    out->length = dst - out->data;
+    out->data[out->length] = '\0';
+    return 1;
+}
+
+// Copies a short string such as finishReason into a fixed buffer, anything
+// that does not fit is cut off
+static int readShortString(struct Scanner *s, char *out, size_t size) {
+    skipWhitespace(s);
+    const char *start = s->p + 1;
+    if (!expect(s, '\"') || !skipStringBody(s))
+        return 0;
+    size_t len = (s->p - 1) - start;
+    if (len >= size)
+        len = size - 1;
+    memcpy(out, start, len);
+    out[len] = '\0';
+    return 1;
+}
+
+static int readNumber(struct Scanner *s, long *value) {
+    skipWhitespace(s);
+    long result = 0;
+    int negative = 0;
+    const char *start = s->p;
+    if (s->p < s->end && *s->p == '-') {
+        negative = 1;
+        s->p++;
+    }
+    while (s->p < s->end && *s->p >= '0' && *s->p <= '9')
+        result = result * 10 + (*s->p++ - '0');
+    if (s->p == start)
+        return 0;
+    // Token counts are integers, but tolerate a fraction or exponent
+    s->p = start;
+    if (!skipValue(s))
+        return 0;
+    *value = negative ? -result : result;
+    return 1;
+}
+
+// Generic object walk: calls onMember for every key, which must consume the
+// value (or return -1 to have it skipped)
+typedef int (*MemberHandler)(struct Scanner *s, const char *key,
+                             size_t keyLength, void *ctx);
+
+static int scanObject(struct Scanner *s, MemberHandler onMember, void *ctx) {
+    if (!expect(s, '{'))
+        return 0;
+    skipWhitespace(s);
+    if (s->p < s->end && *s->p == '}') {
+        s->p++;
+        return 1;
+    }
+    while (1) {
+        const char *key;
+        size_t keyLength;
+        if (!readKey(s, &key, &keyLength))
+            return 0;
+        int handled = onMember(s, key, keyLength, ctx);
+        if (handled == 0)
+            return 0;
+        if (handled < 0 && !skipValue(s))
+            return 0;
+
+        skipWhitespace(s);
+        if (s->p >= s->end)
+            return 0;
+        if (*s->p == '}') {
+            s->p++;
+            return 1;
+        }
+        if (*s->p++ != ',')
+            return 0;
+    }
+}
+
+// Calls onElement for every element of an array, which must consume it
+typedef int (*ElementHandler)(struct Scanner *s, void *ctx);
+
+static int scanArray(struct Scanner *s, ElementHandler onElement, void *ctx) {
+    if (!expect(s, '['))
+        return 0;
+    skipWhitespace(s);
+    if (s->p < s->end && *s->p == ']') {
+        s->p++;
+        return 1;
+    }
+    while (1) {
+        if (!onElement(s, ctx))
+            return 0;
+        skipWhitespace(s);
+        if (s->p >= s->end)
+            return 0;
+        if (*s->p == ']') {
+            s->p++;
+            return 1;
+        }
+        if (*s->p++ != ',')
+            return 0;
+    }
+}
+
+// State while scanning one candidate
+struct CandidateScan {
+    struct StringBuffer text;
+    char *finishReason;
+    size_t finishReasonSize;
+};
+
+static int onPartMember(struct Scanner *s, const char *key, size_t keyLength,
+                        void *ctx) {
+    if (keyIs(key, keyLength, "text"))
+        return readString(s, &((struct CandidateScan *)ctx)->text);
+    return -1;
+}
+
+static int onPart(struct Scanner *s, void *ctx) {
+    skipWhitespace(s);
+    if (s->p < s->end && *s->p != '{')
+        return skipValue(s);
+    return scanObject(s, onPartMember, ctx);
+}
+
+static int onContentMember(struct Scanner *s, const char *key,
+                           size_t keyLength, void *ctx) {
+    if (keyIs(key, keyLength, "parts"))
+        return scanArray(s, onPart, ctx);
+    return -1;
+}
+
+static int onCandidateMember(struct Scanner *s, const char *key,
+                             size_t keyLength, void *ctx) {
+    struct CandidateScan *scan = (struct CandidateScan *)ctx;
+    if (keyIs(key, keyLength, "content"))
+        return scanObject(s, onContentMember, ctx);
+    if (keyIs(key, keyLength, "finishReason"))
+        return readShortString(s, scan->finishReason, scan->finishReasonSize);
+    return -1;
+}
+
+static int onCandidate(struct Scanner *s, void *ctx) {
+    struct GeminiResponse *response = (struct GeminiResponse *)ctx;
+    if (response->candidateCount >= MAX_SCANNED_CANDIDATES)
+        return skipValue(s);
+
+    struct GeminiCandidate *candidate =
+        &response->candidates[response->candidateCount++];
+    struct CandidateScan scan;
+    initStringBuffer(&scan.text);
+    scan.finishReason = candidate->finishReason;
+    scan.finishReasonSize = sizeof(candidate->finishReason);
+
+    int ok = scanObject(s, onCandidateMember, &scan);
+    candidate->length = scan.text.length;
+    candidate->text = detachBuffer(&scan.text);
+    return ok;
+}
+
+static int onUsageMember(struct Scanner *s, const char *key, size_t keyLength,
+                         void *ctx) {
+    struct GeminiResponse *response = (struct GeminiResponse *)ctx;
+    if (keyIs(key, keyLength, "promptTokenCount"))
+        return readNumber(s, &response->promptTokens);
+    if (keyIs(key, keyLength, "candidatesTokenCount"))
+        return readNumber(s, &response->candidatesTokens);
+    if (keyIs(key, keyLength, "totalTokenCount"))
+        return readNumber(s, &response->totalTokens);
+    return -1;
+}
+
+static int onErrorMember(struct Scanner *s, const char *key, size_t keyLength,
+                         void *ctx) {
+    struct GeminiResponse *response = (struct GeminiResponse *)ctx;
+    if (keyIs(key, keyLength, "code"))
+        return readNumber(s, &response->errorCode);
+    if (keyIs(key, keyLength, "message")) {
+        struct StringBuffer message;
+        initStringBuffer(&message);
+        int ok = readString(s, &message);
+        free(response->errorMessage);
+        response->errorMessage = detachBuffer(&message);
+        return ok;
+    }
+    return -1;
+}
+
+static int onRootMember(struct Scanner *s, const char *key, size_t keyLength,
+                        void *ctx) {
+    if (keyIs(key, keyLength, "candidates"))
+        return scanArray(s, onCandidate, ctx);
+    if (keyIs(key, keyLength, "usageMetadata"))
+        return scanObject(s, onUsageMember, ctx);
+    if (keyIs(key, keyLength, "error"))
+        return scanObject(s, onErrorMember, ctx);
+    return -1;
+}
+
+// Error bodies are sometimes wrapped in an array, so scan each element as if
+// it was the root object
+static int onRootElement(struct Scanner *s, void *ctx) {
+    skipWhitespace(s);
+    if (s->p < s->end && *s->p != '{')
+        return skipValue(s);
+    return scanObject(s, onRootMember, ctx);
+}
+
+int scanGeminiResponse(const char *json, size_t length,
+                       struct GeminiResponse *response) {
+    memset(response, 0, sizeof(*response));
+    response->promptTokens = -1;
+    response->candidatesTokens = -1;
+    response->totalTokens = -1;
+    if (!json)
+        return 0;
+
+    struct Scanner s = {json, json + length};
+    skipWhitespace(&s);
+    if (s.p < s.end && *s.p == '[')
+        return scanArray(&s, onRootElement, response);
+    return scanObject(&s, onRootMember, response);
+}
+
+void freeGeminiResponse(struct GeminiResponse *response) {
+    for (int i = 0; i < response->candidateCount; i++)
+        free(response->candidates[i].text);
+    free(response->errorMessage);
+    response->candidateCount = 0;
+    response->errorMessage = NULL;
+}
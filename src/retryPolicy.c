@@ -0,0 +1,133 @@
+#include "retryPolicy.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Retries allowed and the backoff curve of one failure class
+struct RetryPolicy {
+    int maxRetries;
+    long baseMs;  // wait before the first retry, doubled for every next one
+    long capMs;   // longest wait between two attempts
+};
+
+// Indexed by enum FailureClass. Rate limits back off the longest, the quota
+// needs time to refill; network errors are usually over quickest.
+static const struct RetryPolicy policies[] = {
+    {0, 0, 0},         // FAILURE_NONE
+    {0, 0, 0},         // FAILURE_FATAL
+    {3, 200, 2000},    // FAILURE_NETWORK
+    {4, 1000, 16000},  // FAILURE_RATE_LIMIT
+    {3, 500, 8000},    // FAILURE_SERVER
+};
+
+enum FailureClass classifyFailure(CURLcode result, long httpStatus) {
+    switch (result) {
+        case CURLE_OK:
+            break;
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_HTTP2:
+        case CURLE_HTTP2_STREAM:
+            return FAILURE_NETWORK;
+        default:
+            // Cancelled by the user, out of memory, bad options...
+            return FAILURE_FATAL;
+    }
+
+    if (httpStatus == 429)
+        return FAILURE_RATE_LIMIT;
+    if (httpStatus == 408 || (httpStatus >= 500 && httpStatus <= 599))
+        return FAILURE_SERVER;
+    if (httpStatus >= 400)
+        return FAILURE_FATAL;
+    return FAILURE_NONE;
+}
+
+const char *failureName(enum FailureClass failure) {
+    switch (failure) {
+        case FAILURE_NONE:
+            return "ok";
+        case FAILURE_NETWORK:
+            return "network error";
+        case FAILURE_RATE_LIMIT:
+            return "rate limited";
+        case FAILURE_SERVER:
+            return "server error";
+        default:
+            return "error";
+    }
+}
+
+// helper for the jitter, a xorshift generator seeded from the clock so
+// processes started together do not retry in lockstep
+static unsigned long long nextRandom() {
+    static unsigned long long state = 0;
+    if (state == 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        state = (((unsigned long long)ts.tv_nsec * 2654435761ULL) ^
+                 (unsigned long long)ts.tv_sec) |
+                1;
+    }
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+long retryDelayMs(enum FailureClass failure, int retry, long retryAfterS) {
+    const struct RetryPolicy *policy = &policies[failure];
+    if (retry >= policy->maxRetries)
+        return -1;
+
+    // The server knows best when it will have capacity again
+    if (retryAfterS > 0) {
+        if (retryAfterS > MAX_RETRY_AFTER_S)
+            return -1;
+        return retryAfterS * 1000 + (long)(nextRandom() % 250);
+    }
+
+    // "Equal jitter": half of the exponential step is fixed, the other half
+    // random, so waits spread out without ever collapsing to zero
+    long step = policy->baseMs;
+    for (int i = 0; i < retry && step < policy->capMs; i++)
+        step *= 2;
+    if (step > policy->capMs)
+        step = policy->capMs;
+    return step / 2 + (long)(nextRandom() % (unsigned long long)(step / 2 + 1));
+}
+
+void recordLatency(struct LatencyTracker *tracker, double ms) {
+    tracker->samples[tracker->next] = ms;
+    tracker->next = (tracker->next + 1) % LATENCY_SAMPLES;
+    if (tracker->count < LATENCY_SAMPLES)
+        tracker->count++;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+double latencyPercentile(const struct LatencyTracker *tracker, double percent) {
+    if (tracker->count < HEDGE_MIN_SAMPLES)
+        return 0;
+    double sorted[LATENCY_SAMPLES];
+    memcpy(sorted, tracker->samples, tracker->count * sizeof(double));
+    qsort(sorted, tracker->count, sizeof(double), compareDoubles);
+
+    // Nearest rank
+    int rank = (int)(percent / 100.0 * tracker->count + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    if (rank > tracker->count)
+        rank = tracker->count;
+    return sorted[rank - 1];
+}
@@ -0,0 +1,94 @@
+#include "stats.h"
+
+#include <string.h>
+#include <time.h>
+
+double monotonicMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void initTurnStats(struct TurnStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->promptTokens = -1;
+    stats->candidatesTokens = -1;
+    stats->totalTokens = -1;
+}
+
+// helper to read one of libcurl's cumulative timers in milliseconds
+static double timerMs(CURL *curl, CURLINFO info) {
+    curl_off_t us = 0;
+    if (curl_easy_getinfo(curl, info, &us) != CURLE_OK)
+        return 0;
+    return us / 1000.0;
+}
+
+// helper to turn two cumulative timers into the length of the phase between
+// them, phases that were skipped report 0
+static double phaseMs(double end, double start) {
+    return end > start ? end - start : 0;
+}
+
+void collectTransferStats(struct TurnStats *stats, CURL *curl) {
+    // The timers are cumulative since the start of the transfer
+    double lookup = timerMs(curl, CURLINFO_NAMELOOKUP_TIME_T);
+    double connect = timerMs(curl, CURLINFO_CONNECT_TIME_T);
+    double appconnect = timerMs(curl, CURLINFO_APPCONNECT_TIME_T);
+
+    stats->dnsMs = lookup;
+    stats->connectMs = phaseMs(connect, lookup);
+    stats->tlsMs = appconnect > 0 ? phaseMs(appconnect, connect) : 0;
+    stats->ttfbMs = timerMs(curl, CURLINFO_STARTTRANSFER_TIME_T);
+    stats->transferMs = timerMs(curl, CURLINFO_TOTAL_TIME_T);
+
+    curl_off_t bytes = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &bytes) == CURLE_OK)
+        stats->requestBytes = (long)bytes;
+    if (curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes) == CURLE_OK)
+        stats->responseBytes = (long)bytes;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &stats->httpStatus);
+}
+
+void printTurnStats(const struct TurnStats *stats, FILE *out) {
+    fprintf(out,
+            "[stats] prepare %.1fms | dns %.1fms connect %.1fms tls %.1fms "
+            "ttfb %.1fms transfer %.1fms | parse %.1fms display %.1fms | "
+            "sent %ldB received %ldB | http %ld%s%s",
+            stats->prepareMs, stats->dnsMs, stats->connectMs, stats->tlsMs,
+            stats->ttfbMs, stats->transferMs, stats->parseMs,
+            stats->displayMs, stats->requestBytes, stats->responseBytes,
+            stats->httpStatus, stats->cacheHit ? " | cache hit" : "",
+            stats->hedged ? " | hedged" : "");
+    if (stats->retries > 0)
+        fprintf(out, " | %d retr%s", stats->retries,
+                stats->retries == 1 ? "y" : "ies");
+    if (stats->totalTokens >= 0)
+        fprintf(out, " | tokens %ld in %ld out %ld total",
+                stats->promptTokens, stats->candidatesTokens,
+                stats->totalTokens);
+    fprintf(out, "\n");
+}
+
+int appendTurnStats(const struct TurnStats *stats, const char *path) {
+    FILE *file = fopen(path, "a");
+    if (!file)
+        return 0;
+    fprintf(file,
+            "{\"time\":%ld,\"prepare_ms\":%.3f,\"dns_ms\":%.3f,"
+            "\"connect_ms\":%.3f,\"tls_ms\":%.3f,\"ttfb_ms\":%.3f,"
+            "\"transfer_ms\":%.3f,\"parse_ms\":%.3f,\"display_ms\":%.3f,"
+            "\"request_bytes\":%ld,\"response_bytes\":%ld,\"http_status\":%ld,"
+            "\"cache_hit\":%s,\"retries\":%d,\"hedged\":%s,"
+            "\"prompt_tokens\":%ld,\"candidates_tokens\":%ld,"
+            "\"total_tokens\":%ld}\n",
+            (long)time(NULL), stats->prepareMs, stats->dnsMs,
+            stats->connectMs, stats->tlsMs, stats->ttfbMs, stats->transferMs,
+            stats->parseMs, stats->displayMs, stats->requestBytes,
+            stats->responseBytes, stats->httpStatus,
+            stats->cacheHit ? "true" : "false", stats->retries,
+            stats->hedged ? "true" : "false", stats->promptTokens,
+            stats->candidatesTokens, stats->totalTokens);
+    fclose(file);
+    return 1;
+}
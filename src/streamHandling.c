@@ -0,0 +1,145 @@
+#include "streamHandling.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsonHandling.h"
+#include "stats.h"
+
+void initStreamState(struct StreamState *state, struct Renderer *renderer,
+                     struct ByteRing *ring) {
+    initStringBuffer(&state->pending);
+    initStringBuffer(&state->event);
+    initStringBuffer(&state->text);
+    initStringBuffer(&state->other);
+    initAnswerInfo(&state->info);
+    state->renderer = renderer;
+    state->ring = ring;
+    state->parseMs = 0;
+    state->renderMs = 0;
+}
+
+// Hands a fragment to the rendering thread, waiting while the ring is full
+static void queueFragment(struct ByteRing *ring, const char *text,
+                          size_t len) {
+    while (len > 0) {
+        size_t n = ringWrite(ring, text, len);
+        if (n == 0)
+            sleep_ms(1);
+        text += n;
+        len -= n;
+    }
+}
+
+// Parses one complete event and renders (or queues) its text fragment right
+// away
+static int dispatchEvent(struct StreamState *state) {
+    if (state->event.length == 0)
+        return 1;
+
+    double start = monotonicMs();
+    char *fragment = parse_gemini_chunk(state->event.data, &state->info);
+    clearBuffer(&state->event);
+    double parsed = monotonicMs();
+    state->parseMs += parsed - start;
+    if (!fragment)
+        return 1;
+
+    size_t len = strlen(fragment);
+    if (state->ring) {
+        queueFragment(state->ring, fragment, len);
+    } else {
+        renderText(state->renderer, fragment, len);
+        state->renderMs += monotonicMs() - parsed;
+    }
+    int ok = appendToBuffer(&state->text, fragment, len);
+    free(fragment);
+    return ok;
+}
+
+// Handles a single line of the stream, without its line terminator
+static int processLine(struct StreamState *state, char *line, size_t len) {
+    if (len > 0 && line[len - 1] == '\r')
+        len--;
+
+    // A blank line terminates the current event
+    if (len == 0)
+        return dispatchEvent(state);
+
+    // Only "data:" fields carry payload. Other lines are kept aside, they are
+    // only read when the request failed.
+    if (len < 5 || strncmp(line, "data:", 5) != 0)
+        return appendToBuffer(&state->other, line, len) &&
+               appendToBuffer(&state->other, "\n", 1);
+    line += 5;
+    len -= 5;
+    if (len > 0 && line[0] == ' ') {
+        line++;
+        len--;
+    }
+
+    // Multiple data lines of one event are joined with a newline
+    if (state->event.length > 0 && !appendToBuffer(&state->event, "\n", 1))
+        return 0;
+    return appendToBuffer(&state->event, line, len);
+}
+
+size_t StreamCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    struct StreamState *state = (struct StreamState *)userp;
+    char *data = (char *)contents;
+    size_t start = 0;
+
+    for (size_t i = 0; i < realsize; i++) {
+        if (data[i] != '\n')
+            continue;
+
+        int ok;
+        if (state->pending.length > 0) {
+            // The line started in an earlier callback, complete it first
+            if (!appendToBuffer(&state->pending, data + start, i - start))
+                return 0;
+            ok = processLine(state, state->pending.data, state->pending.length);
+            clearBuffer(&state->pending);
+        } else {
+            ok = processLine(state, data + start, i - start);
+        }
+        if (!ok)
+            return 0;
+        start = i + 1;
+    }
+
+    // Keep the unterminated tail for the next callback
+    if (start < realsize &&
+        !appendToBuffer(&state->pending, data + start, realsize - start))
+        return 0;
+
+    // Events that arrived in the same network read are shown together
+    if (!state->ring) {
+        double flushStart = monotonicMs();
+        flushRender(state->renderer);
+        state->renderMs += monotonicMs() - flushStart;
+    }
+    return realsize;
+}
+
+char *finishStream(struct StreamState *state) {
+    if (state->pending.length > 0) {
+        processLine(state, state->pending.data, state->pending.length);
+        clearBuffer(&state->pending);
+    }
+    dispatchEvent(state);
+    if (!state->ring)
+        flushRender(state->renderer);
+    return state->text.length > 0 ? state->text.data : NULL;
+}
+
+void freeStreamState(struct StreamState *state) {
+    freeStringBuffer(&state->pending);
+    freeStringBuffer(&state->event);
+    freeStringBuffer(&state->text);
+    freeStringBuffer(&state->other);
+    state->renderer = NULL;
+    state->ring = NULL;
+}
@@ -0,0 +1,58 @@
+#include "stringBuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void initStringBuffer(struct StringBuffer *buf) {
+    buf->data = NULL;
+    buf->length = 0;
+    buf->capacity = 0;
+}
+
+int reserveBuffer(struct StringBuffer *buf, size_t extra) {
+    size_t needed = buf->length + extra + 1;  // +1 for the terminating '\0'
+    if (needed <= buf->capacity)
+        return 1;
+
+    // Double the capacity so n appends cost O(n) copies in total
+    size_t capacity = buf->capacity ? buf->capacity : 64;
+    while (capacity < needed)
+        capacity *= 2;
+
+    char *data = realloc(buf->data, capacity);
+    if (!data)
+        return 0;
+    buf->data = data;
+    buf->capacity = capacity;
+    return 1;
+}
+
+int appendToBuffer(struct StringBuffer *buf, const char *bytes, size_t len) {
+    if (!reserveBuffer(buf, len))
+        return 0;
+    memcpy(buf->data + buf->length, bytes, len);
+    buf->length += len;
+    buf->data[buf->length] = '\0';
+    return 1;
+}
+
+int appendStringToBuffer(struct StringBuffer *buf, const char *str) {
+    return appendToBuffer(buf, str, strlen(str));
+}
+
+void clearBuffer(struct StringBuffer *buf) {
+    buf->length = 0;
+    if (buf->data)
+        buf->data[0] = '\0';
+}
+
+char *detachBuffer(struct StringBuffer *buf) {
+    char *data = buf->data;
+    initStringBuffer(buf);
+    return data;
+}
+
+void freeStringBuffer(struct StringBuffer *buf) {
+    free(buf->data);
+    initStringBuffer(buf);
+}
@@ -0,0 +1,155 @@
+#include "summarizer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "history.h"
+#include "jsonHandling.h"
+#include "stringBuffer.h"
+
+static size_t collectBody(void *contents, size_t size, size_t nmemb,
+                          void *userp) {
+    size_t realsize = size * nmemb;
+    if (!appendToBuffer((struct StringBuffer *)userp, contents, realsize))
+        return 0;
+    return realsize;
+}
+
+// Runs on the worker thread with its own handle, nothing is shared with the
+// chat loop except the fields of the summarizer it was started with
+static void *summaryWorker(void *arg) {
+    struct Summarizer *summarizer = (struct Summarizer *)arg;
+    struct RequestContext *ctx = &summarizer->ctx;
+    struct ChatHistory request;
+    struct StringBuffer body;
+    initHistory(&request);
+    initStringBuffer(&body);
+
+    addTurn(&request, "user", summarizer->prompt);
+    const char *post_data = preparePostData(&request, NULL);
+    CURLcode res = post_data
+                       ? performRequest(ctx, post_data, collectBody, &body)
+                       : CURLE_OUT_OF_MEMORY;
+
+    long status = 0;
+    curl_easy_getinfo(ctx->curl, CURLINFO_RESPONSE_CODE, &status);
+    if (res == CURLE_OK && status == 200 && body.data)
+        summarizer->result = parse_gemini_response(body.data, NULL);
+
+    free((void *)post_data);
+    freeStringBuffer(&body);
+    freeHistory(&request);
+    atomic_store(&summarizer->done, 1);
+    return NULL;
+}
+
+void initSummarizer(struct Summarizer *summarizer,
+                    const struct ApiConfig *config, size_t maxWords) {
+    memset(summarizer, 0, sizeof(*summarizer));
+    atomic_init(&summarizer->done, 0);
+    summarizer->config = config;
+    summarizer->maxWords = maxWords;
+}
+
+int startSummary(struct Summarizer *summarizer, const char *previousSummary,
+                 const char *droppedTurns) {
+    if (summarizer->running)
+        return 0;
+
+    struct StringBuffer prompt;
+    initStringBuffer(&prompt);
+    char limit[128];
+    snprintf(limit, sizeof(limit),
+             "Summarize the conversation below in at most %zu words. Keep "
+             "facts, names, decisions and open questions.\n\n",
+             summarizer->maxWords);
+    appendStringToBuffer(&prompt, limit);
+    if (previousSummary) {
+        appendStringToBuffer(&prompt, "Summary so far:\n");
+        appendStringToBuffer(&prompt, previousSummary);
+        appendStringToBuffer(&prompt, "\n\n");
+    }
+    appendStringToBuffer(&prompt, "Conversation:\n");
+    appendStringToBuffer(&prompt, droppedTurns);
+    if (!prompt.data)
+        return 0;
+
+    struct StringBuffer copy;
+    initStringBuffer(&copy);
+    if (!appendStringToBuffer(&copy, droppedTurns)) {
+        freeStringBuffer(&prompt);
+        return 0;
+    }
+    char *turns = detachBuffer(&copy);
+
+    // The handle is made here rather than on the worker, so stopSummarizer
+    // can always cancel it. A stalled request must not keep "stop" waiting.
+    if (!initRequestContext(&summarizer->ctx, summarizer->config, 0)) {
+        free(turns);
+        freeStringBuffer(&prompt);
+        return 0;
+    }
+    curl_easy_setopt(summarizer->ctx.curl, CURLOPT_TIMEOUT, SUMMARY_TIMEOUT_S);
+
+    free(summarizer->prompt);
+    free(summarizer->turns);
+    summarizer->prompt = detachBuffer(&prompt);
+    summarizer->turns = turns;
+    summarizer->result = NULL;
+    atomic_store(&summarizer->done, 0);
+    if (pthread_create(&summarizer->thread, NULL, summaryWorker, summarizer) !=
+        0) {
+        cleanupRequestContext(&summarizer->ctx);
+        return 0;
+    }
+    summarizer->running = 1;
+    return 1;
+}
+
+// helper to wait for the worker and release its handle
+static void joinWorker(struct Summarizer *summarizer) {
+    pthread_join(summarizer->thread, NULL);
+    cleanupRequestContext(&summarizer->ctx);
+    summarizer->running = 0;
+}
+
+char *takeSummary(struct Summarizer *summarizer, struct StringBuffer *dropped) {
+    if (!summarizer->running || !atomic_load(&summarizer->done))
+        return NULL;
+
+    joinWorker(summarizer);
+    char *result = summarizer->result;
+    summarizer->result = NULL;
+
+    // Turns dropped since the summary started are newer, so the turns of a
+    // failed summary go in front of them
+    if (!result) {
+        struct StringBuffer turns;
+        initStringBuffer(&turns);
+        if (appendStringToBuffer(&turns, summarizer->turns) &&
+            (dropped->length == 0 ||
+             appendToBuffer(&turns, dropped->data, dropped->length))) {
+            freeStringBuffer(dropped);
+            *dropped = turns;
+        } else {
+            freeStringBuffer(&turns);
+        }
+    }
+    free(summarizer->turns);
+    summarizer->turns = NULL;
+    return result;
+}
+
+void stopSummarizer(struct Summarizer *summarizer) {
+    if (summarizer->running) {
+        cancelRequest(&summarizer->ctx);
+        joinWorker(summarizer);
+    }
+    free(summarizer->result);
+    free(summarizer->prompt);
+    free(summarizer->turns);
+    summarizer->result = NULL;
+    summarizer->prompt = NULL;
+    summarizer->turns = NULL;
+}
@@ -0,0 +1,358 @@
+// A local stand-in for the Gemini API, so askai can be benchmarked and tested
+// without the network. It answers generateContent and streamGenerateContent
+// (alt=sse) with synthetic text, with configurable latency, chunking, answer
+// size and error rate.
+//
+// Build with "make mockgemini", then point askai at it:
+//   ./mockgemini --port 8080 --latency 200 --chunks 20 --chunk-delay 30 &
+//   askai --endpoint http://127.0.0.1:8080/v1beta "hello"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stringBuffer.h"
+
+// Behaviour of the server, set from the command line
+struct MockOptions {
+    int port;
+    long latencyMs;     // delay before the first byte of every response
+    int chunks;         // number of SSE events a streamed answer is split in
+    long chunkDelayMs;  // delay between two SSE events
+    size_t size;        // bytes of answer text
+    double errorRate;   // fraction of requests answered with 429 or 503
+    int retryAfter;     // seconds sent in Retry-After with a 429
+    int quiet;
+};
+
+static struct MockOptions options = {8080, 0, 8, 0, 1024, 0.0, 1, 0};
+
+static void sleepMs(long milliseconds) {
+    if (milliseconds <= 0)
+        return;
+    struct timespec req;
+    req.tv_sec = milliseconds / 1000;
+    req.tv_nsec = (milliseconds % 1000) * 1000000L;
+    nanosleep(&req, NULL);
+}
+
+// helper to send the whole buffer, returns 0 once the client is gone
+static int sendAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent <= 0)
+            return 0;
+        data += sent;
+        length -= sent;
+    }
+    return 1;
+}
+
+// Builds size bytes of answer text, already escaped for a JSON string
+static void makeAnswerText(struct StringBuffer *out, size_t size) {
+    static const char *words[] = {"This ",   "is ",     "a ",
+                                  "mocked ", "answer ", "from ",
+                                  "the ",    "local ",  "\\\"Gemini\\\" ",
+                                  "server.", "\\n"};
+    size_t i = 0;
+    while (out->length < size)
+        appendStringToBuffer(out, words[i++ % 11]);
+}
+
+// helper to write the response head, body framing depends on the caller
+static int sendHead(int fd, int status, const char *reason,
+                    const char *contentType, long contentLength,
+                    const char *extraHeaders) {
+    char head[512];
+    int len;
+    if (contentLength >= 0) {
+        len = snprintf(head, sizeof(head),
+                       "HTTP/1.1 %d %s\r\nContent-Type: %s\r\n"
+                       "Content-Length: %ld\r\n%s\r\n",
+                       status, reason, contentType, contentLength,
+                       extraHeaders ? extraHeaders : "");
+    } else {
+        len = snprintf(head, sizeof(head),
+                       "HTTP/1.1 %d %s\r\nContent-Type: %s\r\n"
+                       "Transfer-Encoding: chunked\r\n%s\r\n",
+                       status, reason, contentType,
+                       extraHeaders ? extraHeaders : "");
+    }
+    return sendAll(fd, head, len);
+}
+
+static int sendJson(int fd, int status, const char *reason, const char *body,
+                    const char *extraHeaders) {
+    size_t length = strlen(body);
+    return sendHead(fd, status, reason, "application/json; charset=UTF-8",
+                    (long)length, extraHeaders) &&
+           sendAll(fd, body, length);
+}
+
+// Answers with an API error instead of a candidate, as the real service does
+// when it is rate limited or overloaded
+static int sendError(int fd) {
+    if (rand() % 2 == 0) {
+        char retry[64];
+        snprintf(retry, sizeof(retry), "Retry-After: %d\r\n",
+                 options.retryAfter);
+        return sendJson(fd, 429, "Too Many Requests",
+                        "{\"error\":{\"code\":429,\"message\":\"Resource has "
+                        "been exhausted (e.g. check quota).\",\"status\":"
+                        "\"RESOURCE_EXHAUSTED\"}}",
+                        retry);
+    }
+    return sendJson(fd, 503, "Service Unavailable",
+                    "{\"error\":{\"code\":503,\"message\":\"The model is "
+                    "overloaded. Please try again later.\",\"status\":"
+                    "\"UNAVAILABLE\"}}",
+                    NULL);
+}
+
+static int sendGenerateContent(int fd) {
+    struct StringBuffer body;
+    initStringBuffer(&body);
+    appendStringToBuffer(&body,
+                         "{\"candidates\":[{\"content\":{\"parts\":[{\"text\":"
+                         "\"");
+    makeAnswerText(&body, body.length + options.size);
+    appendStringToBuffer(
+        &body,
+        "\"}],\"role\":\"model\"},\"finishReason\":\"STOP\",\"safetyRatings\":"
+        "[{\"category\":\"HARM_CATEGORY_HATE_SPEECH\",\"probability\":"
+        "\"NEGLIGIBLE\"},{\"category\":\"HARM_CATEGORY_HARASSMENT\","
+        "\"probability\":\"NEGLIGIBLE\"}]}],\"usageMetadata\":{"
+        "\"promptTokenCount\":10,\"candidatesTokenCount\":100,"
+        "\"totalTokenCount\":110},\"modelVersion\":\"mock\"}");
+    int ok = sendJson(fd, 200, "OK", body.data, NULL);
+    freeStringBuffer(&body);
+    return ok;
+}
+
+// helper to send one piece of a chunked body
+static int sendChunk(int fd, const char *data, size_t length) {
+    char size[32];
+    int len = snprintf(size, sizeof(size), "%zx\r\n", length);
+    return sendAll(fd, size, len) && sendAll(fd, data, length) &&
+           sendAll(fd, "\r\n", 2);
+}
+
+static int sendStreamGenerateContent(int fd) {
+    if (!sendHead(fd, 200, "OK", "text/event-stream", -1, NULL))
+        return 0;
+
+    struct StringBuffer text;
+    initStringBuffer(&text);
+    makeAnswerText(&text, options.size);
+
+    // Split the text into roughly equal events, never inside an escape
+    int chunks = options.chunks > 0 ? options.chunks : 1;
+    size_t per_chunk = text.length / chunks + 1;
+    size_t offset = 0;
+    int ok = 1;
+    struct StringBuffer event;
+    initStringBuffer(&event);
+    for (int i = 0; ok && i < chunks; i++) {
+        size_t end = offset + per_chunk;
+        if (end > text.length || i == chunks - 1)
+            end = text.length;
+        size_t backslashes = 0;
+        while (end - backslashes > offset &&
+               text.data[end - 1 - backslashes] == '\\')
+            backslashes++;
+        if (backslashes % 2 == 1)
+            end--;
+
+        clearBuffer(&event);
+        appendStringToBuffer(&event,
+                             "data: {\"candidates\":[{\"content\":{\"parts\":"
+                             "[{\"text\":\"");
+        appendToBuffer(&event, text.data + offset, end - offset);
+        appendStringToBuffer(&event, "\"}],\"role\":\"model\"}");
+        if (i == chunks - 1)
+            appendStringToBuffer(
+                &event,
+                ",\"finishReason\":\"STOP\"}],\"usageMetadata\":{"
+                "\"promptTokenCount\":10,\"candidatesTokenCount\":100,"
+                "\"totalTokenCount\":110}}\r\n\r\n");
+        else
+            appendStringToBuffer(&event, "}]}\r\n\r\n");
+        offset = end;
+
+        if (i > 0)
+            sleepMs(options.chunkDelayMs);
+        ok = sendChunk(fd, event.data, event.length);
+    }
+    ok = ok && sendAll(fd, "0\r\n\r\n", 5);
+    freeStringBuffer(&event);
+    freeStringBuffer(&text);
+    return ok;
+}
+
+// helper to find a header value in the raw head, case-insensitively
+static const char *findHeader(const char *head, const char *name) {
+    size_t name_len = strlen(name);
+    const char *line = strstr(head, "\r\n");
+    while (line && line[2] != '\r') {
+        line += 2;
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ')
+                value++;
+            return value;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return NULL;
+}
+
+// Serves requests on one keep-alive connection until the client closes it
+static void *serveConnection(void *arg) {
+    int fd = (int)(long)arg;
+    struct StringBuffer in;
+    initStringBuffer(&in);
+    char block[16384];
+
+    while (1) {
+        // Read until the end of the request head
+        char *head_end;
+        while (!in.data || !(head_end = strstr(in.data, "\r\n\r\n"))) {
+            ssize_t n = recv(fd, block, sizeof(block), 0);
+            if (n <= 0)
+                goto done;
+            appendToBuffer(&in, block, n);
+        }
+
+        size_t head_len = head_end + 4 - in.data;
+        const char *length_header = findHeader(in.data, "Content-Length");
+        size_t body_len = length_header ? strtoul(length_header, NULL, 10) : 0;
+        const char *connection = findHeader(in.data, "Connection");
+        int keep_alive =
+            !(connection && strncasecmp(connection, "close", 5) == 0);
+
+        // Read the rest of the body, it is not used for anything
+        while (in.length < head_len + body_len) {
+            ssize_t n = recv(fd, block, sizeof(block), 0);
+            if (n <= 0)
+                goto done;
+            appendToBuffer(&in, block, n);
+        }
+
+        char method[16] = {0};
+        char path[1024] = {0};
+        sscanf(in.data, "%15s %1023s", method, path);
+        if (!options.quiet)
+            fprintf(stderr, "%s %s (%zu bytes)\n", method, path, body_len);
+
+        sleepMs(options.latencyMs);
+        int ok;
+        if (strcmp(method, "POST") == 0 &&
+            strstr(path, ":streamGenerateContent")) {
+            ok = (double)rand() / RAND_MAX < options.errorRate
+                     ? sendError(fd)
+                     : sendStreamGenerateContent(fd);
+        } else if (strcmp(method, "POST") == 0 &&
+                   strstr(path, ":generateContent")) {
+            ok = (double)rand() / RAND_MAX < options.errorRate
+                     ? sendError(fd)
+                     : sendGenerateContent(fd);
+        } else if (strcmp(method, "HEAD") == 0 || strcmp(method, "GET") == 0) {
+            // Lets clients open and check a connection cheaply
+            ok = sendHead(fd, 200, "OK", "text/plain", 0, NULL);
+        } else {
+            ok = sendJson(fd, 404, "Not Found",
+                          "{\"error\":{\"code\":404,\"message\":\"Unknown "
+                          "method\",\"status\":\"NOT_FOUND\"}}",
+                          NULL);
+        }
+        if (!ok || !keep_alive)
+            break;
+
+        // Keep anything pipelined after this request
+        size_t used = head_len + body_len;
+        memmove(in.data, in.data + used, in.length - used);
+        in.length -= used;
+        in.data[in.length] = '\0';
+    }
+
+done:
+    freeStringBuffer(&in);
+    close(fd);
+    return NULL;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [--port N] [--latency MS] [--chunks N] "
+            "[--chunk-delay MS]\n"
+            "          [--size BYTES] [--error-rate FRACTION] "
+            "[--retry-after SECONDS] [--quiet]\n",
+            name);
+}
+
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+            options.port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc)
+            options.latencyMs = atol(argv[++i]);
+        else if (strcmp(argv[i], "--chunks") == 0 && i + 1 < argc)
+            options.chunks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--chunk-delay") == 0 && i + 1 < argc)
+            options.chunkDelayMs = atol(argv[++i]);
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            options.size = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--error-rate") == 0 && i + 1 < argc)
+            options.errorRate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--retry-after") == 0 && i + 1 < argc)
+            options.retryAfter = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--quiet") == 0)
+            options.quiet = 1;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    srand((unsigned)time(NULL));
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(options.port);
+    if (bind(server, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server, 128) != 0) {
+        perror("mockgemini");
+        return 1;
+    }
+    fprintf(stderr, "mockgemini listening on http://127.0.0.1:%d/v1beta\n",
+            options.port);
+
+    // One detached thread per connection, so concurrent clients and
+    // keep-alive connections are served independently
+    while (1) {
+        int fd = accept(server, NULL, NULL);
+        if (fd < 0)
+            continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, serveConnection, (void *)(long)fd) !=
+            0) {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+}